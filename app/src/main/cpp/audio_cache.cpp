@@ -0,0 +1,305 @@
+#include "audio_cache.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <utime.h>
+
+#define TAG  "AudioCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static constexpr uint32_t AC_MAGIC = 0x31434154;   // "TAC1"
+
+//  Spill file "<key>.pcm":  [ AcFileHeader | int16 × n_samples ]
+
+struct AcFileHeader {
+    uint32_t magic;
+    uint32_t n_samples;
+    uint64_t key;
+};
+
+struct MemEntry {
+    uint64_t             key;
+    std::vector<int16_t> pcm;
+};
+
+struct DiskEntry {
+    uint64_t key;
+    size_t   bytes;
+};
+
+static std::mutex g_mu;
+static size_t     g_mem_max  = 0;
+static size_t     g_disk_max = 0;
+static std::string g_dir;
+static AcStats    g_stats    = {};
+
+// Most recently used first
+static std::list<MemEntry>  g_mem;
+static std::unordered_map<uint64_t, std::list<MemEntry>::iterator>  g_mem_index;
+// Least recently used first. File reads, writes and deletes happen outside
+// g_mu; only this bookkeeping is done under it.
+static std::list<DiskEntry> g_disk;
+static std::unordered_map<uint64_t, std::list<DiskEntry>::iterator> g_disk_index;
+static std::unordered_set<uint64_t> g_disk_writing;   // being written by a put
+
+static uint64_t fnv1a(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+static std::string spill_path(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.pcm", (unsigned long long)key);
+    return g_dir + name;
+}
+
+uint64_t ac_key(const std::string& text, const std::string& voice,
+                float length_scale, float noise_scale, float noise_scale_w, float speed) {
+    // Whitespace differences do not change what VITS says
+    std::string norm;
+    norm.reserve(text.size());
+    for (unsigned char c : text) {
+        if (isspace(c)) { if (!norm.empty() && norm.back() != ' ') norm += ' '; }
+        else norm += (char)c;
+    }
+    if (!norm.empty() && norm.back() == ' ') norm.pop_back();
+
+    uint64_t h = fnv1a(norm.data(), norm.size());
+    h = fnv1a("\x1f", 1, h);
+    h = fnv1a(voice.data(), voice.size(), h);
+    const float params[] = { length_scale, noise_scale, noise_scale_w, speed };
+    return fnv1a(params, sizeof(params), h);
+}
+
+static void mem_evict() {
+    while ((size_t)g_stats.mem_bytes > g_mem_max && !g_mem.empty()) {
+        g_stats.mem_bytes -= (int64_t)(g_mem.back().pcm.size() * sizeof(int16_t));
+        g_mem_index.erase(g_mem.back().key);
+        g_mem.pop_back();
+    }
+}
+
+static void mem_insert(uint64_t key, std::vector<int16_t>&& pcm) {
+    const size_t bytes = pcm.size() * sizeof(int16_t);
+    if (bytes > g_mem_max || g_mem_index.count(key)) return;
+    g_mem.push_front({ key, std::move(pcm) });
+    g_mem_index[key] = g_mem.begin();
+    g_stats.mem_bytes += (int64_t)bytes;
+    mem_evict();
+}
+
+// Drops the least recently used entries over the cap; their files are
+// appended to doomed, for the caller to delete once g_mu is released.
+static void disk_evict(std::vector<std::string>& doomed) {
+    while ((size_t)g_stats.disk_bytes > g_disk_max && !g_disk.empty()) {
+        doomed.push_back(spill_path(g_disk.front().key));
+        g_stats.disk_bytes -= (int64_t)g_disk.front().bytes;
+        g_disk_index.erase(g_disk.front().key);
+        g_disk.pop_front();
+    }
+}
+
+static void unlink_all(const std::vector<std::string>& paths) {
+    for (const std::string& p : paths) unlink(p.c_str());
+}
+
+static void disk_track(uint64_t key, size_t bytes) {
+    g_disk.push_back({ key, bytes });
+    g_disk_index[key] = std::prev(g_disk.end());
+    g_stats.disk_bytes += (int64_t)bytes;
+}
+
+static void disk_forget(uint64_t key) {
+    auto it = g_disk_index.find(key);
+    if (it == g_disk_index.end()) return;
+    g_stats.disk_bytes -= (int64_t)it->second->bytes;
+    g_disk.erase(it->second);
+    g_disk_index.erase(it);
+}
+
+struct SpillFile { uint64_t key; size_t bytes; time_t used; };
+
+// Spill files left by earlier runs in dir, least recently used first.
+// Deletes temporaries orphaned by a crash mid-write. Called without g_mu.
+static std::vector<SpillFile> disk_scan(const std::string& dir) {
+    std::vector<SpillFile> found;
+    DIR* d = opendir(dir.c_str());
+    if (!d) { LOGE("Cannot open spill dir %s", dir.c_str()); return found; }
+
+    while (dirent* e = readdir(d)) {
+        const size_t len = strlen(e->d_name);
+        if (len > 4 && strcmp(e->d_name + len - 4, ".tmp") == 0) {
+            unlink((dir + "/" + e->d_name).c_str());
+            continue;
+        }
+        unsigned long long key;
+        char ext[8];
+        if (len != 20 ||
+            sscanf(e->d_name, "%16llx.%3s", &key, ext) != 2 || strcmp(ext, "pcm") != 0) {
+            continue;
+        }
+        struct stat st;
+        if (stat((dir + "/" + e->d_name).c_str(), &st) != 0) continue;
+        found.push_back({ (uint64_t)key, (size_t)st.st_size, st.st_mtime });
+    }
+    closedir(d);
+
+    std::sort(found.begin(), found.end(),
+              [](const SpillFile& a, const SpillFile& b) { return a.used < b.used; });
+    return found;
+}
+
+// Called without g_mu.
+static bool disk_read(const std::string& path, uint64_t key, std::vector<int16_t>& pcm) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    AcFileHeader hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == AC_MAGIC && hdr.key == key;
+    if (ok) {
+        pcm.resize(hdr.n_samples);
+        ok = fread(pcm.data(), sizeof(int16_t), pcm.size(), f) == pcm.size();
+    }
+    fclose(f);
+    if (ok) utime(path.c_str(), nullptr);   // recency survives a restart
+    return ok;
+}
+
+// Returns the file's size, or 0 if it could not be written. Called without g_mu.
+static size_t disk_write(const std::string& path, uint64_t key, const std::vector<int16_t>& pcm) {
+    // Written under a temporary name so a crash never leaves a torn entry;
+    // disk_scan() deletes the temporary if it does
+    const std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) { LOGE("Cannot write %s", tmp.c_str()); return 0; }
+    const AcFileHeader hdr = { AC_MAGIC, (uint32_t)pcm.size(), key };
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(pcm.data(), sizeof(int16_t), pcm.size(), f) == pcm.size();
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) { unlink(tmp.c_str()); return 0; }
+    return sizeof(hdr) + pcm.size() * sizeof(int16_t);
+}
+
+void ac_configure(size_t mem_bytes, const char* spill_dir, size_t disk_bytes) {
+    const std::string dir = mem_bytes > 0 && spill_dir ? spill_dir : "";
+    bool rescan;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        rescan = dir != g_dir;
+    }
+    const std::vector<SpillFile> found = rescan && !dir.empty() ? disk_scan(dir)
+                                                                : std::vector<SpillFile>();
+    std::vector<std::string> doomed;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        g_mem_max  = mem_bytes;
+        g_disk_max = disk_bytes;
+        mem_evict();
+        if (rescan) {
+            g_dir = dir;
+            g_disk.clear();
+            g_disk_index.clear();
+            g_stats.disk_bytes = 0;
+            for (const SpillFile& f : found) disk_track(f.key, f.bytes);
+        }
+        disk_evict(doomed);
+        LOGI("Audio cache: mem=%zu KB, spill=%s (%zu entries, %lld KB)",
+             mem_bytes / 1024, g_dir.empty() ? "off" : g_dir.c_str(),
+             g_disk.size(), (long long)g_stats.disk_bytes / 1024);
+    }
+    unlink_all(doomed);
+}
+
+bool ac_lookup(uint64_t key, std::vector<float>& out) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        if (g_mem_max == 0) return false;
+
+        auto it = g_mem_index.find(key);
+        if (it != g_mem_index.end()) {
+            g_mem.splice(g_mem.begin(), g_mem, it->second);
+            const std::vector<int16_t>& pcm = g_mem.front().pcm;
+            out.resize(pcm.size());
+            for (size_t i = 0; i < pcm.size(); ++i) out[i] = pcm[i] / 32767.0f;
+            g_stats.hits++;
+            return true;
+        }
+        auto dit = g_disk_index.find(key);
+        if (dit == g_disk_index.end()) {
+            g_stats.misses++;
+            return false;
+        }
+        g_disk.splice(g_disk.end(), g_disk, dit->second);   // most recently used
+        path = spill_path(key);
+    }
+
+    std::vector<int16_t> loaded;
+    if (!disk_read(path, key, loaded)) {
+        {
+            std::lock_guard<std::mutex> lock(g_mu);
+            disk_forget(key);
+            g_stats.misses++;
+        }
+        unlink(path.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_stats.disk_hits++;
+    out.resize(loaded.size());
+    for (size_t i = 0; i < loaded.size(); ++i) out[i] = loaded[i] / 32767.0f;
+    mem_insert(key, std::move(loaded));
+    return true;
+}
+
+void ac_put(uint64_t key, const float* pcm, int n_samples) {
+    if (n_samples <= 0) return;
+    std::vector<int16_t> q(n_samples);
+    for (int i = 0; i < n_samples; ++i) {
+        const float s = std::max(-1.0f, std::min(1.0f, pcm[i]));
+        q[i] = (int16_t)lrintf(s * 32767.0f);
+    }
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        if (g_mem_max == 0) return;
+        g_stats.puts++;
+        if (!g_dir.empty() && !g_disk_index.count(key) && g_disk_writing.insert(key).second) {
+            path = spill_path(key);
+        }
+        if (path.empty()) { mem_insert(key, std::move(q)); return; }
+    }
+
+    const size_t bytes = disk_write(path, key, q);
+
+    std::vector<std::string> doomed;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        g_disk_writing.erase(key);
+        // Reconfigured to another directory meanwhile: the file is not ours to track
+        if (bytes > 0 && path == spill_path(key) && !g_disk_index.count(key)) {
+            disk_track(key, bytes);
+            disk_evict(doomed);
+        }
+        if (g_mem_max > 0) mem_insert(key, std::move(q));
+    }
+    unlink_all(doomed);
+}
+
+AcStats ac_stats() {
+    std::lock_guard<std::mutex> lock(g_mu);
+    return g_stats;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cache of synthesized TTS audio, so segments the app speaks over and over
+// ("Please repeat that", greetings, fixed kiosk replies) play without
+// running VITS again.
+//
+// Entries are keyed by a hash of the whitespace-normalized text, the MMS
+// voice and every synthesis parameter that changes the waveform. Samples
+// are kept as int16 (half the size of the float PCM the TTS produces) in
+// an LRU bounded by bytes. With a spill directory, each entry is also
+// written through to a small file there, so stock phrases survive restarts;
+// the directory is bounded too and loses its least recently used files
+// first (a file's mtime records its last use, so the order survives a
+// restart). Disk reads and writes run outside the cache's lock.
+
+struct AcStats {
+    int64_t hits;        // served from memory
+    int64_t disk_hits;   // served from the spill directory
+    int64_t misses;
+    int64_t puts;
+    int64_t mem_bytes;
+    int64_t disk_bytes;
+};
+
+// mem_bytes = 0 disables the cache and frees it; an empty spill_dir keeps
+// it memory-only. Spilled files from earlier runs are picked up again.
+void     ac_configure(size_t mem_bytes, const char* spill_dir, size_t disk_bytes);
+uint64_t ac_key(const std::string& text, const std::string& voice,
+                float length_scale, float noise_scale, float noise_scale_w, float speed);
+bool     ac_lookup(uint64_t key, std::vector<float>& out);
+void     ac_put(uint64_t key, const float* pcm, int n_samples);
+AcStats  ac_stats();
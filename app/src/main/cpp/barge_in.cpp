@@ -0,0 +1,46 @@
+#include "barge_in.h"
+#include <android/log.h>
+#include <atomic>
+#include <chrono>
+
+#define TAG  "BargeIn"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<bool>     g_enabled{false};
+static std::atomic<int>      g_min_gap_ms{300};
+static std::atomic<bool>     g_busy{false};
+static std::atomic<uint64_t> g_epoch{0};
+static std::atomic<int64_t>  g_busy_since_ms{0};
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now().time_since_epoch()).count();
+}
+
+void barge_in_configure(bool enabled, int min_speech_gap_ms) {
+    g_enabled    = enabled;
+    g_min_gap_ms = min_speech_gap_ms;
+    LOGI("Barge-in %s (min gap %d ms)", enabled ? "ON" : "OFF", min_speech_gap_ms);
+}
+
+void barge_in_set_busy(bool busy) {
+    if (busy) g_busy_since_ms = now_ms();
+    g_busy = busy;
+}
+
+bool barge_in_on_speech_start() {
+    if (!g_enabled || !g_busy) return false;
+    // Speech right at the start of a turn is the tail of the utterance we are
+    // already answering, not a new one.
+    if (now_ms() - g_busy_since_ms < g_min_gap_ms) return false;
+
+    const uint64_t e = g_epoch.fetch_add(1) + 1;
+    LOGI("Barge-in: preempting current turn (epoch %llu)", (unsigned long long)e);
+    return true;
+}
+
+uint64_t barge_in_epoch() {
+    return g_epoch.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// Barge-in policy for conversation mode.
+//
+// A turn is "busy" from the start of translation until its last audio has
+// drained. If the VAD reports new speech while busy, the policy bumps the
+// barge-in epoch: Llama stops decoding at the next token, and the Kotlin
+// synthesis/playback workers, which compare the epoch they started with,
+// drop queued segments and fade out the current one.
+
+void     barge_in_configure(bool enabled, int min_speech_gap_ms);
+void     barge_in_set_busy(bool busy);
+// Called on VAD speech start. Returns true if outstanding work was preempted;
+// the caller should then submit the new utterance at raised priority.
+bool     barge_in_on_speech_start();
+uint64_t barge_in_epoch();
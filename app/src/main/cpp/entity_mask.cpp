@@ -0,0 +1,339 @@
+#include "entity_mask.h"
+#include "utf8.h"
+#include <cctype>
+#include <cstring>
+
+static const char PLACEHOLDER[] = "\xC2\xA7";   // §
+static constexpr size_t PLACEHOLDER_LEN = 2;
+
+// ── Number styles ─────────────────────────────────────────────────────────────
+
+struct NumberStyle {
+    const char* group;     // thousands separator
+    const char* decimal;
+    bool        indian;    // 12,34,567: groups of two above the thousands
+    unsigned    zero;      // code point of the digit zero
+};
+
+static const NumberStyle STYLE_EN     = { ",", ".", false, 0x30 };
+static const NumberStyle STYLE_INDIAN = { ",", ".", true,  0x30 };
+static const NumberStyle STYLE_FR     = { "\xE2\x80\xAF", ",", false, 0x30 };   // narrow no-break space
+static const NumberStyle STYLE_DE     = { ".", ",", false, 0x30 };
+static const NumberStyle STYLE_AR     = { "\xD9\xAC", "\xD9\xAB", false, 0x660 };   // ٬ ٫ ٠
+
+static const NumberStyle& style_for(const std::string& lang) {
+    if (lang == "Hindi" || lang == "Marathi" || lang == "Tamil" || lang == "Telugu") {
+        return STYLE_INDIAN;
+    }
+    if (lang == "French")                      return STYLE_FR;
+    if (lang == "German" || lang == "Spanish") return STYLE_DE;
+    if (lang == "Arabic")                      return STYLE_AR;
+    return STYLE_EN;
+}
+
+static void append_utf8(std::string& out, unsigned cp) {
+    if (cp < 0x80) { out += (char)cp; return; }
+    if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+    } else {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+    }
+    out += (char)(0x80 | (cp & 0x3F));
+}
+
+// Integer and fraction digits (ASCII) in the target style. Grouped when the
+// source grouped them or the number is long enough to need it, so a year
+// stays as spoken.
+static std::string render_number(const std::string& int_digits, const std::string& frac,
+                                 bool grouped, const NumberStyle& st) {
+    std::string out;
+    const size_t n = int_digits.size();
+    const bool group = grouped || n >= 5;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t left = n - i;   // digits from here to the end of the integer part
+        if (group && i > 0 &&
+            (left == 3 || (left > 3 && (st.indian ? (left - 3) % 2 == 0 : left % 3 == 0)))) {
+            out += st.group;
+        }
+        append_utf8(out, st.zero + (unsigned)(int_digits[i] - '0'));
+    }
+    if (!frac.empty()) {
+        out += st.decimal;
+        for (char c : frac) append_utf8(out, st.zero + (unsigned)(c - '0'));
+    }
+    return out;
+}
+
+// ── Detection ─────────────────────────────────────────────────────────────────
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Letters and digits in any script: non-ASCII bytes count as letters
+static bool is_word(char c) {
+    const unsigned char u = (unsigned char)c;
+    return u >= 0x80 || isalnum(u);
+}
+
+static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n'; }
+
+static const char* const CURRENCIES[] = {
+    "$", "\xE2\x82\xAC", "\xC2\xA3", "\xE2\x82\xB9", "\xC2\xA5",   // $ € £ ₹ ¥
+};
+
+static size_t currency_at(const std::string& s, size_t i) {
+    for (const char* c : CURRENCIES) {
+        const size_t n = strlen(c);
+        if (s.compare(i, n, c) == 0) return n;
+    }
+    return 0;
+}
+
+// End of a URL or e-mail address starting at i, or 0.
+static size_t link_end(const std::string& s, size_t i) {
+    size_t j = i;
+    while (j < s.size() && !is_space(s[j])) ++j;
+    // Sentence punctuation after the address isn't part of it
+    while (j > i && strchr(".,!?;:)\"'", s[j - 1])) --j;
+    const std::string w = s.substr(i, j - i);
+    if (w.compare(0, 7, "http://") == 0 || w.compare(0, 8, "https://") == 0 ||
+        w.compare(0, 4, "www.") == 0) {
+        return j;
+    }
+    const size_t at = w.find('@');
+    if (at != std::string::npos && at > 0 && w.find('.', at + 2) != std::string::npos) return j;
+    return 0;
+}
+
+// Digit groups separated by spaces alone, as phone numbers are written
+// ("98765 43210", "555 123 4567"); other spaced numbers ("1990 2000",
+// "10 20 30 40") are not one.
+static bool phone_shaped(const int* groups, int n) {
+    if (n == 2) return groups[0] == 5 && groups[1] == 5;
+    if (n == 3) return groups[0] == 3 && groups[1] == 3 && groups[2] == 4;
+    return false;
+}
+
+// End of a phone number starting at i ("+91 98765 43210", "555-1234",
+// "(555) 123-4567" after its bracket), or 0.
+static size_t phone_end(const std::string& s, size_t i) {
+    size_t j = i, end = 0;
+    const bool plus = s[j] == '+';
+    if (plus) ++j;
+    static constexpr int MAX_GROUPS = 6;
+    int groups[MAX_GROUPS] = {}, n_groups = 1, digits = 0;
+    bool marked = plus;   // a '+', dash or bracket makes it a phone number
+    while (j < s.size()) {
+        if (is_digit(s[j])) { ++digits; ++groups[n_groups - 1]; end = ++j; continue; }
+        // A separator counts only between digits
+        size_t k = j;
+        bool mark = false;
+        while (k < s.size() && (s[k] == ' ' || s[k] == '-' || s[k] == '(' || s[k] == ')')) {
+            mark |= s[k++] != ' ';
+        }
+        if (k == j || k - j > 2 || k >= s.size() || !is_digit(s[k]) || n_groups == MAX_GROUPS) break;
+        marked |= mark;
+        ++n_groups;
+        j = k;
+    }
+    if (digits < 7 || n_groups < 2) return 0;
+    if (!marked && !phone_shaped(groups, n_groups)) return 0;
+    return end < s.size() && is_word(s[end]) ? 0 : end;
+}
+
+// End of a time or date starting at i ("10:30", "12/05/2024"), or 0.
+static size_t clock_end(const std::string& s, size_t i) {
+    size_t j = i;
+    int groups = 0;
+    while (true) {
+        const size_t g = j;
+        while (j < s.size() && is_digit(s[j])) ++j;
+        if (j == g || j - g > 4) return 0;
+        ++groups;
+        if (j + 1 < s.size() && (s[j] == ':' || s[j] == '/') && is_digit(s[j + 1])) { ++j; continue; }
+        break;
+    }
+    if (groups < 2 || (j < s.size() && is_word(s[j]))) return 0;
+    return j;
+}
+
+struct Number {
+    size_t      end = 0;
+    std::string int_digits, frac;
+    bool        grouped = false;
+};
+
+// A number starting at i in the source's notation. end = 0 if none.
+static Number number_at(const std::string& s, size_t i, const NumberStyle& src) {
+    Number num;
+    const char group = src.decimal[0] == ',' ? '.' : ',';
+    const char dec   = src.decimal[0];
+    size_t j = i;
+    while (j < s.size() && is_digit(s[j])) num.int_digits += s[j++];
+    if (num.int_digits.empty()) return num;
+
+    // Grouping: 1,234,567 (or 12,34,567 for Indian-style sources)
+    const size_t first = num.int_digits.size();
+    while (first <= 3 && j < s.size() && s[j] == group) {
+        size_t k = j + 1, g = 0;
+        while (k < s.size() && is_digit(s[k])) { ++k; ++g; }
+        const bool last = !(k < s.size() && s[k] == group && k + 1 < s.size() && is_digit(s[k + 1]));
+        if (!(g == 3 || (g == 2 && src.indian && !last))) break;
+        num.int_digits.append(s, j + 1, g);
+        num.grouped = true;
+        j = k;
+    }
+    if (j + 1 < s.size() && s[j] == dec && is_digit(s[j + 1])) {
+        ++j;
+        while (j < s.size() && is_digit(s[j])) num.frac += s[j++];
+    }
+    if (j < s.size() && is_word(s[j])) return num;   // 3rd, 4G, mp3
+    num.end = j;
+    return num;
+}
+
+// ── Masking ───────────────────────────────────────────────────────────────────
+
+// Gives value the lowest free number.
+static void add(EntityMap& map, std::string& out, std::string value) {
+    size_t k = 0;
+    while (k < map.values.size() && !map.values[k].empty()) ++k;
+    if (k == map.values.size()) {
+        map.values.emplace_back();
+        map.used.push_back(false);
+    }
+    map.values[k] = std::move(value);
+    map.used[k]   = false;
+    map.current.push_back((int)k + 1);
+    out += PLACEHOLDER;
+    out += std::to_string(k + 1);
+}
+
+void entity_release(EntityMap& map, const std::vector<int>& numbers) {
+    for (int n : numbers) {
+        if (n >= 1 && (size_t)n <= map.values.size()) map.values[n - 1].clear();
+    }
+    while (!map.values.empty() && map.values.back().empty()) {
+        map.values.pop_back();
+        map.used.pop_back();
+    }
+}
+
+std::string entity_mask(const std::string& text, const std::string& src,
+                        const std::string& tgt, EntityMap& map) {
+    map.current.clear();
+    map.pending.clear();
+    const NumberStyle& in  = style_for(src);
+    const NumberStyle& fmt = style_for(tgt);
+
+    // Detection reads plain, text with every digit as ASCII; at[k] is the
+    // offset in text of plain[k], so spans are copied from text as spoken
+    std::string plain;
+    std::vector<size_t> at;
+    plain.reserve(text.size());
+    at.reserve(text.size() + 1);
+    for (size_t i = 0; i < text.size();) {
+        int n;
+        const int d = utf8_digit(std::string_view(text).substr(i), n);
+        if (d >= 0 && n > 1) {
+            plain += (char)('0' + d);
+            at.push_back(i);
+        } else {
+            for (int k = 0; k < n; ++k) { plain += text[i + k]; at.push_back(i + k); }
+        }
+        i += n;
+    }
+    at.push_back(text.size());
+    std::string out;
+    out.reserve(text.size());
+    const auto span = [&](size_t b, size_t e) { return text.substr(at[b], at[e] - at[b]); };
+    const auto keep = [&](size_t b, size_t e) { out.append(text, at[b], at[e] - at[b]); };
+
+    size_t i = 0;
+    while (i < plain.size()) {
+        const bool boundary = i == 0 || !is_word(plain[i - 1]);
+        if (!boundary) { keep(i, i + 1); ++i; continue; }
+
+        size_t end = link_end(plain, i);
+        if (!end && (is_digit(plain[i]) || (plain[i] == '+' && i + 1 < plain.size() &&
+                                            is_digit(plain[i + 1])))) {
+            end = phone_end(plain, i);
+            if (!end) end = clock_end(plain, i);
+        }
+        if (end) {
+            add(map, out, span(i, end));
+            i = end;
+            continue;
+        }
+
+        const size_t cur = currency_at(plain, i);
+        const size_t num_at = i + cur;
+        if (num_at < plain.size() && is_digit(plain[num_at])) {
+            const Number num = number_at(plain, num_at, in);
+            if (num.end) {
+                const bool percent = num.end < plain.size() && plain[num.end] == '%';
+                // Short plain integers gain nothing from a two-token placeholder
+                if (cur || percent || !num.frac.empty() || num.int_digits.size() >= 3) {
+                    std::string v = plain.substr(i, cur) +
+                                    render_number(num.int_digits, num.frac, num.grouped, fmt);
+                    if (percent) v += '%';
+                    add(map, out, std::move(v));
+                    i = num.end + (percent ? 1 : 0);
+                    continue;
+                }
+                keep(i, num.end);
+                i = num.end;
+                continue;
+            }
+        }
+        keep(i, i + 1);
+        ++i;
+    }
+    return out;
+}
+
+// ── Restoring ─────────────────────────────────────────────────────────────────
+
+// Resolves a complete placeholder held in pending ("§" + digits).
+static void resolve(EntityMap& map, std::string& out) {
+    const std::string digits = map.pending.substr(PLACEHOLDER_LEN);
+    const size_t n = digits.empty() ? 0 : (size_t)std::stoul(digits);
+    if (n >= 1 && n <= map.values.size() && !map.values[n - 1].empty()) {
+        out += map.values[n - 1];
+        map.used[n - 1] = true;
+    } else {
+        out += map.pending;   // not one of ours
+    }
+    map.pending.clear();
+}
+
+void entity_restore(EntityMap& map, const std::string& piece, std::string& out) {
+    out.clear();
+    if (map.values.empty()) { out = piece; return; }
+    const size_t width = std::to_string(map.values.size()).size();   // digits of the last
+    for (size_t i = 0; i < piece.size(); ) {
+        if (!map.pending.empty()) {
+            if (is_digit(piece[i]) && map.pending.size() < PLACEHOLDER_LEN + width) {
+                map.pending += piece[i++];
+                continue;
+            }
+            resolve(map, out);
+            continue;
+        }
+        if (piece.compare(i, PLACEHOLDER_LEN, PLACEHOLDER) == 0) {
+            map.pending.assign(PLACEHOLDER);
+            i += PLACEHOLDER_LEN;
+            continue;
+        }
+        out += piece[i++];
+    }
+}
+
+void entity_restore_end(EntityMap& map, bool append_missing, std::string& out) {
+    out.clear();
+    if (!map.pending.empty()) resolve(map, out);
+    if (!append_missing) return;
+    for (int n : map.current) {
+        if (!map.used[n - 1]) { out += ' '; out += map.values[n - 1]; }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Swaps entities in a transcript for short placeholders before it is given
+// to Llama, and puts them back in the streamed translation.
+//
+// Numbers, amounts, percentages, phone numbers, times, dates, URLs and
+// e-mail addresses become "§1", "§2", ... (two tokens each), so the model
+// neither spends steps copying them digit by digit nor mistranslates them.
+// Numbers are parsed with the source language's separators and rendered in
+// the target's (grouping, decimal mark, digits); the rest is restored as
+// spoken. Names are left to the model: most targets need them transliterated
+// into their own script, which a verbatim copy can't do. Digits of the
+// Arabic and Indic scripts and Thai are read like ASCII ones.
+//
+// A map can span several turns kept in the KV cache (rolling history): a
+// turn's placeholders take numbers no resident turn holds, so one left in an
+// earlier turn never stands for a value of the current one, and the model
+// copying it forward still restores the right value. An evicted turn gives
+// its numbers back (entity_release), so they stay as short as the entities
+// resident at once allow.
+
+struct EntityMap {
+    std::vector<std::string> values;    // rendered for the target; "§n" is values[n - 1], "" free
+    std::vector<bool>        used;
+    std::vector<int>         current;   // numbers the last entity_mask() gave out
+    std::string              pending;   // a placeholder cut off at the end of a piece
+};
+
+// text with entities replaced; map receives them in its free numbers.
+// src, tgt: language names.
+std::string entity_mask(const std::string& text, const std::string& src,
+                        const std::string& tgt, EntityMap& map);
+
+// Frees numbers (from current) whose turn has left the KV cache.
+void entity_release(EntityMap& map, const std::vector<int>& numbers);
+
+// Appends piece to out with placeholders replaced. A placeholder split
+// across pieces is held until it is complete.
+void entity_restore(EntityMap& map, const std::string& piece, std::string& out);
+
+// Releases anything held. With append_missing, entities of the current turn
+// the model dropped are added at the end, so a phone number is never lost.
+void entity_restore_end(EntityMap& map, bool append_missing, std::string& out);
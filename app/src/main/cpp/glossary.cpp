@@ -0,0 +1,167 @@
+#include "glossary.h"
+#include "translation_memory.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#define TAG  "Glossary"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+//  Byte-level Aho-Corasick: a trie of the normalized phrases plus, per node,
+//  the failure link (longest proper suffix that is also a trie path) and the
+//  dictionary link (nearest node on the failure chain that ends a phrase).
+
+struct AcNode {
+    std::vector<std::pair<uint8_t, int>> next;   // sorted by byte
+    int fail = 0;
+    int dict = -1;
+    int out  = -1;   // entry ending exactly here
+};
+
+struct Entry {
+    std::string phrase;
+    std::string translation;
+    int         len;   // normalized length in bytes
+};
+
+struct Automaton {
+    std::vector<AcNode> nodes = std::vector<AcNode>(1);
+    std::vector<Entry>  entries;
+};
+
+static std::mutex g_mu;
+static std::unordered_map<std::string, std::unique_ptr<Automaton>> g_pairs;
+
+static std::string pair_key(const std::string& src, const std::string& tgt) {
+    return src + '\x1f' + tgt;
+}
+
+static int child(const AcNode& n, uint8_t c) {
+    auto it = std::lower_bound(n.next.begin(), n.next.end(), std::make_pair(c, 0));
+    return it != n.next.end() && it->first == c ? it->second : -1;
+}
+
+static void insert(Automaton& a, const std::string& key, int entry) {
+    int s = 0;
+    for (unsigned char c : key) {
+        int t = child(a.nodes[s], c);
+        if (t < 0) {
+            t = (int)a.nodes.size();
+            auto& next = a.nodes[s].next;
+            next.insert(std::lower_bound(next.begin(), next.end(), std::make_pair(c, 0)),
+                        { c, t });
+            a.nodes.emplace_back();
+        }
+        s = t;
+    }
+    // A repeated phrase keeps its last translation
+    a.nodes[s].out = entry;
+}
+
+static void link(Automaton& a) {
+    std::vector<int> queue;
+    for (auto& e : a.nodes[0].next) queue.push_back(e.second);
+    for (size_t qi = 0; qi < queue.size(); ++qi) {
+        const int s = queue[qi];
+        for (auto& e : a.nodes[s].next) {
+            int f = a.nodes[s].fail;
+            int t;
+            while ((t = child(a.nodes[f], e.first)) < 0 && f != 0) f = a.nodes[f].fail;
+            const int fail = t >= 0 && t != e.second ? t : 0;
+            a.nodes[e.second].fail = fail;
+            a.nodes[e.second].dict = a.nodes[fail].out >= 0 ? fail : a.nodes[fail].dict;
+            queue.push_back(e.second);
+        }
+    }
+}
+
+int glossary_load(const char* path) {
+    std::ifstream in(path);
+    if (!in) { LOGE("Cannot read phrasebook %s", path); return -1; }
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::unordered_map<std::string, std::unique_ptr<Automaton>> pairs;
+    std::string line;
+    int n = 0;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<std::string> f;
+        size_t pos = 0;
+        for (size_t tab; (tab = line.find('\t', pos)) != std::string::npos; pos = tab + 1) {
+            f.push_back(line.substr(pos, tab - pos));
+        }
+        f.push_back(line.substr(pos));
+        if (f.size() < 4) continue;
+        const std::string key = tm_normalize(f[2]);
+        if (key.empty() || f[3].empty()) continue;
+
+        auto& a = pairs[pair_key(f[0], f[1])];
+        if (!a) a = std::make_unique<Automaton>();
+        a->entries.push_back({ f[2], f[3], (int)key.size() });
+        insert(*a, key, (int)a->entries.size() - 1);
+        ++n;
+    }
+    for (auto& p : pairs) link(*p.second);
+
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_pairs.swap(pairs);
+    LOGI("Phrasebook: %d entries, %zu language pairs, compiled in %.1f ms", n, g_pairs.size(),
+         std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - t0).count());
+    return n;
+}
+
+bool glossary_match(const std::string& src_lang, const std::string& tgt_lang,
+                    const std::string& text, std::vector<GlossaryHit>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(g_mu);
+    auto it = g_pairs.find(pair_key(src_lang, tgt_lang));
+    if (it == g_pairs.end()) return false;
+    const Automaton& a = *it->second;
+    const std::string norm = tm_normalize(text);
+    const int n = (int)norm.size();
+
+    // Every whole-word occurrence: (start, entry)
+    std::vector<std::pair<int, int>> found;
+    int s = 0;
+    for (int i = 0; i < n; ++i) {
+        const uint8_t c = (uint8_t)norm[i];
+        int t;
+        while ((t = child(a.nodes[s], c)) < 0 && s != 0) s = a.nodes[s].fail;
+        s = t >= 0 ? t : 0;
+
+        const bool end_ok = i + 1 == n || norm[i + 1] == ' ' || norm[i + 1] == '?';
+        if (!end_ok) continue;
+        for (int o = a.nodes[s].out >= 0 ? s : a.nodes[s].dict; o >= 0; o = a.nodes[o].dict) {
+            const int e     = a.nodes[o].out;
+            const int start = i + 1 - a.entries[e].len;
+            if (start == 0 || norm[start - 1] == ' ') found.push_back({ start, e });
+        }
+    }
+
+    // Leftmost, then longest, skipping anything overlapping a kept match
+    std::sort(found.begin(), found.end(), [&](const auto& x, const auto& y) {
+        return x.first != y.first ? x.first < y.first
+                                  : a.entries[x.second].len > a.entries[y.second].len;
+    });
+    int covered = 0;
+    for (const auto& f : found) {
+        if (f.first < covered) continue;
+        const Entry& e = a.entries[f.second];
+        out.push_back({ e.phrase, e.translation, f.first, f.first + e.len });
+        covered = f.first + e.len;
+    }
+    return out.size() == 1 && out[0].start == 0 && out[0].end == n;
+}
+
+void glossary_clear() {
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_pairs.clear();
+}
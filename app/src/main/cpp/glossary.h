@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Phrasebook of mandated translations (medical terms, place names, fixed
+// replies), compiled into one Aho-Corasick automaton per language pair.
+//
+// The phrasebook is a UTF-8 TSV file, one entry per line:
+//
+//     <src lang> \t <tgt lang> \t <phrase> \t <translation>
+//
+// Lines starting with '#' are comments. Phrases are matched against the
+// transcript after tm_normalize(), on whole words only, in one pass over
+// the text however many entries there are. Overlapping matches resolve to
+// the leftmost, then the longest.
+
+struct GlossaryHit {
+    std::string phrase;        // as written in the phrasebook
+    std::string translation;
+    int         start;         // byte range in the normalized transcript
+    int         end;
+};
+
+// Replaces the loaded phrasebook. Returns the number of entries, -1 if the
+// file cannot be read.
+int  glossary_load(const char* path);
+// Non-overlapping matches, in transcript order. Returns true when a single
+// entry covers the whole transcript.
+bool glossary_match(const std::string& src_lang, const std::string& tgt_lang,
+                    const std::string& text, std::vector<GlossaryHit>& out);
+void glossary_clear();
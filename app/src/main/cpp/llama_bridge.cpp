@@ -1,41 +1,198 @@
 #include "llama_bridge.h"
+#include "pipeline_stages.h"
+#include "thread_budget.h"
+#include "thermal_monitor.h"
+#include "barge_in.h"
+#include "model_tiers.h"
+#include "vocab_table.h"
+#include "prompt_templates.h"
+#include "script_mask.h"
+#include "output_rules.h"
+#include "entity_mask.h"
 #include "llama.cpp/include/llama.h"
 #include "llama.cpp/ggml/include/ggml-cpu.h"
 #include <android/log.h>
+#include <chrono>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <unordered_map>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
 
 #define TAG  "LlamaBridge"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
-static llama_model*   g_model   = nullptr;
-static llama_context* g_ctx     = nullptr;
-static int            g_threads = 4;
+static constexpr int CONV_DIRS      = 2;
+static constexpr int MAX_NEW_TOKENS = 512;
+static constexpr int SIMUL_UNITS    = 160;   // tier-selection size of a simul session, in chars
+static constexpr int FALLBACK_N_CTX = 1024;  // KV of tiers past the first; a turn plus its answer fits
 
-bool llama_bridge_init(const char* model_path, int n_threads, int n_ctx) {
-    g_threads = n_threads;
+// Template parts for one language pair, tokenized once per tier.
+struct PromptParts {
+    std::string              head;        // rendered; keys snapshots and cached heads
+    std::vector<llama_token> head_toks;   // BOS included
+    std::vector<llama_token> open;
+    std::vector<llama_token> tail;
+    std::vector<llama_token> close;
+    // A turn's source is tokenized in one piece with the plain text around
+    // it, up to the boundaries where the model's own tokenization would split
+    // too: a newline or a control token (see turn_tokens).
+    std::string              body_open;   // open
+    std::string              body_close;  // tail up to its first newline / control token
+    std::vector<llama_token> tail_rest;   // the rest of tail
+};
+
+// A LoRA adapter for one language pair, on one tier.
+struct PairAdapter {
+    llama_adapter_lora* lora;
+    float               scale;
+    std::string         head;          // replaces the template head; empty = keep
+    uint64_t            fingerprint;   // file and scale; keys snapshots
+};
+
+struct LlamaTier {
+    llama_model*   model;
+    llama_context* ctx;
+    int            n_ctx;
+    uint64_t       fingerprint;   // keys prefix snapshots to these weights
+    std::shared_ptr<const VocabTable> pieces;   // shared by tiers with the same vocab
+    const PromptTemplate* tmpl;
+    std::unordered_map<std::string, PromptParts> prompts;   // by "src\x1ftgt"
+    std::unordered_map<int, std::vector<llama_token>> allowed;   // by Script
+    std::shared_ptr<const OutputRules> rules;   // from tmpl; shared like pieces
+    std::unordered_map<std::string, PairAdapter> adapters;       // by "src\x1ftgt"
+    std::unordered_map<std::string, llama_adapter_lora*> loras;  // by path, loaded once
+    uint64_t       active_adapter = 0;   // fingerprint of the one set on ctx, 0 = none
+};
+
+static std::vector<LlamaTier> g_tiers;          // best quality first
+static ggml_threadpool*       g_pool  = nullptr;   // see Thread pool below
+static int                    g_tier  = 0;      // active tier
+static llama_model*           g_model = nullptr;
+static llama_context*         g_ctx   = nullptr;
+static int                    g_n_ctx     = 2048;
+static int                    g_n_threads = 4;
+
+static const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static uint64_t fnv1a(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+// Identifies the weights without reading the whole file.
+static uint64_t model_fingerprint(const llama_model* model, const char* path) {
+    char desc[128] = {};
+    llama_model_desc(model, desc, sizeof(desc));
+    struct stat sb {};
+    stat(path, &sb);
+    const uint64_t v[] = { llama_model_size(model), llama_model_n_params(model),
+                           (uint64_t)sb.st_size, (uint64_t)sb.st_mtime };
+    return fnv1a(v, sizeof(v), fnv1a(desc, strlen(desc)));
+}
 
+// Models are mmapped, so an idle tier costs address space and its KV cache,
+// not resident weights. Fallback tiers get a smaller KV: they are picked when
+// latency is short, so they serve single turns rather than long history.
+bool llama_bridge_add_tier(const char* model_path) {
     llama_model_params mp = llama_model_default_params();
     mp.n_gpu_layers = 0;
 
-    g_model = llama_model_load_from_file(model_path, mp);
-    if (!g_model) { LOGE("Failed to load: %s", model_path); return false; }
+    llama_model* model = llama_model_load_from_file(model_path, mp);
+    if (!model) { LOGE("Failed to load: %s", model_path); return false; }
 
+    const int n_ctx = g_tiers.empty() ? g_n_ctx : std::min(g_n_ctx, FALLBACK_N_CTX);
     llama_context_params cp = llama_context_default_params();
     cp.n_ctx           = (uint32_t)n_ctx;
-    cp.n_threads       = (uint32_t)n_threads;
-    cp.n_threads_batch = (uint32_t)n_threads;
+    cp.n_threads       = (uint32_t)g_n_threads;
+    cp.n_threads_batch = (uint32_t)g_n_threads;
+    cp.n_seq_max       = CONV_DIRS;   // one sequence per conversation direction
+    cp.kv_unified      = true;        // sequences share cells: a single sequence gets full n_ctx
 
 
-    g_ctx = llama_init_from_model(g_model, cp);
-    if (!g_ctx) {
+    llama_context* ctx = llama_init_from_model(model, cp);
+    if (!ctx) {
         LOGE("Failed to create context");
-        llama_model_free(g_model); g_model = nullptr;
+        llama_model_free(model);
         return false;
     }
 
+    auto built = std::make_shared<VocabTable>();
+    vocab_table_build(llama_model_get_vocab(model), *built);
+    std::shared_ptr<const VocabTable> pieces = built;
+    for (const LlamaTier& t : g_tiers) {
+        if (t.pieces->offsets == built->offsets && t.pieces->bytes == built->bytes) {
+            pieces = t.pieces;
+            break;
+        }
+    }
+
+    const PromptTemplate& tmpl = prompt_template_for(model);
+    std::shared_ptr<const OutputRules> rules;
+    for (const LlamaTier& t : g_tiers) {
+        if (t.pieces == pieces && t.tmpl == &tmpl) { rules = t.rules; break; }
+    }
+    if (!rules) {
+        auto r = std::make_shared<OutputRules>();
+        output_rules_build(llama_model_get_vocab(model), *pieces, tmpl, *r);
+        rules = r;
+    }
+
+    g_tiers.push_back({ model, ctx, n_ctx, model_fingerprint(model, model_path), pieces,
+                        &tmpl, {}, {}, rules });
+    if (g_pool) llama_attach_threadpool(ctx, g_pool, g_pool);
+    tier_add(STAGE_LLAMA, base_name(model_path), model_path);
+    if (!g_ctx) { g_model = model; g_ctx = ctx; g_tier = 0; }
+    return true;
+}
+
+// Tier-selection size of text: its characters, which unlike tokens are the
+// same for every tier's vocabulary and unlike bytes don't weigh non-Latin
+// scripts two or three times.
+static double text_units(const std::string& s) {
+    size_t n = 0;
+    for (unsigned char c : s) n += (c & 0xC0) != 0x80;
+    return (double)n;
+}
+
+// Translation turns queued behind the current one, as the app counts them
+static std::atomic<int> g_backlog { 0 };
+
+void llama_bridge_backlog_add(int delta) {
+    g_backlog += delta;
+}
+
+// Switches the active tier for a request of the given size. Stage held.
+static void select_tier(double units) {
+    const int t = tier_select(STAGE_LLAMA, units, std::max(0, g_backlog.load()));
+    g_tier  = t;
+    g_model = g_tiers[t].model;
+    g_ctx   = g_tiers[t].ctx;
+}
+
+bool llama_bridge_init(const char* model_path, int n_threads, int n_ctx) {
+    llama_bridge_free();
+    budget_set_max(STAGE_LLAMA, n_threads);
+    g_n_ctx     = n_ctx;
+    g_n_threads = n_threads;
+
+    if (!llama_bridge_add_tier(model_path)) return false;
+
 #if defined(__ARM_FEATURE_BF16) || defined(__ARM_FEATURE_BF16_VECTOR_ARITHMETIC)
     const char* bf16 = "YES";
 #else
@@ -49,54 +206,1083 @@ bool llama_bridge_init(const char* model_path, int n_threads, int n_ctx) {
 }
 
 
-void llama_bridge_translate(const std::string& prompt,
-                            std::function<void(const std::string&)> on_token) {
-    if (!g_ctx || !g_model) return;
-    llama_memory_clear(llama_get_memory(g_ctx), true);
-    const llama_vocab* vocab = llama_model_get_vocab(g_model);
+// ── Thread pool ───────────────────────────────────────────────────────────────
+//
+//  Llama's ggml workers live in one persistent threadpool, attached to every
+//  tier's context, so a decode step doesn't spawn threads. A pool keeps the
+//  affinity it was created with, so it is created pinned to the stage's core
+//  mask and rebuilt whenever the thread budget moves the stage to other
+//  cores or changes its thread count (StageScope::refresh()).
+
+static int      g_pool_threads = 0;
+static uint64_t g_pool_mask    = 0;
+
+static void attach_pool(ggml_threadpool* tp) {
+    for (LlamaTier& t : g_tiers) {
+        if (tp) llama_attach_threadpool(t.ctx, tp, tp);
+        else    llama_detach_threadpool(t.ctx);
+    }
+}
+
+static void free_pool() {
+    if (!g_pool) return;
+    attach_pool(nullptr);
+    ggml_threadpool_free(g_pool);
+    g_pool = nullptr;
+}
+
+// Sizes and pins the workers to the stage's current config. Stage held.
+static void use_threads(const StageScope& stage) {
+    const int      n    = stage.n_threads();
+    const uint64_t mask = stage_config(STAGE_LLAMA).core_mask;
+    if (!g_pool || g_pool_threads != n || g_pool_mask != mask) {
+        free_pool();
+        ggml_threadpool_params p = ggml_threadpool_params_default(n);
+        for (int i = 0; i < 64; ++i) p.cpumask[i] = (mask >> i) & 1;   // none set = inherit
+        p.strict_cpu = false;   // each worker may use any core of the mask
+        g_pool = ggml_threadpool_new(&p);
+        if (g_pool) {
+            attach_pool(g_pool);
+            g_pool_threads = n;
+            g_pool_mask    = mask;
+        } else {
+            LOGE("Threadpool creation failed; workers spawn per graph");
+        }
+    }
+    llama_set_n_threads(g_ctx, n, n);
+}
+
+// ── Helpers ───────────────────────────────────────────────────────────────────
 
-    // Tokenize
-    std::vector<llama_token> toks(prompt.size() + 64);
-    int n = llama_tokenize(vocab, prompt.c_str(), (int)prompt.size(),
-                           toks.data(), (int)toks.size(), true, true);
+// parse_special = false for user text, so a transcript can never produce
+// control tokens.
+static std::vector<llama_token> tokenize(const std::string& text, bool add_special,
+                                         bool parse_special = true) {
+    const llama_vocab* vocab = llama_model_get_vocab(g_model);
+    std::vector<llama_token> toks(text.size() + 64);
+    int n = llama_tokenize(vocab, text.c_str(), (int)text.size(),
+                           toks.data(), (int)toks.size(), add_special, parse_special);
     if (n < 0) {
         toks.resize(-n);
-        n = llama_tokenize(vocab, prompt.c_str(), (int)prompt.size(),
-                           toks.data(), (int)toks.size(), true, true);
+        n = llama_tokenize(vocab, text.c_str(), (int)text.size(),
+                           toks.data(), (int)toks.size(), add_special, parse_special);
     }
-    if (n <= 0) { LOGE("Tokenization failed"); return; }
-    toks.resize(n);
+    toks.resize(n > 0 ? n : 0);
+    return toks;
+}
+
+static std::string pair_key(const std::string& src, const std::string& tgt) {
+    return src + '\x1f' + tgt;
+}
+
+// The active tier's template for src → tgt (language names), tokenized on
+// first use. A pair adapter's own head replaces the template's. Stage held.
+static const PromptParts& prompt_parts(const std::string& src, const std::string& tgt) {
+    LlamaTier& tier = g_tiers[g_tier];
+    const std::string key = pair_key(src, tgt);
+    auto it = tier.prompts.find(key);
+    if (it != tier.prompts.end()) return it->second;
+
+    const PromptTemplate& t = *tier.tmpl;
+    auto ad = tier.adapters.find(key);
+    const bool own_head = ad != tier.adapters.end() && !ad->second.head.empty();
+    PromptParts pp;
+    pp.head      = prompt_render(own_head ? ad->second.head.c_str() : t.head, src, tgt);
+    pp.head_toks = tokenize(pp.head, true);
+    pp.open      = tokenize(t.open,  false);
+    pp.tail      = tokenize(t.tail,  false);
+    pp.close     = tokenize(t.close, false);
+    const size_t lead = strcspn(t.tail, "\n<");
+    pp.body_open  = t.open;
+    pp.body_close = std::string(t.tail, lead);
+    pp.tail_rest  = tokenize(t.tail + lead, false);
+    return tier.prompts.emplace(key, std::move(pp)).first->second;
+}
 
-    // ✅ REMOVED: llama_kv_cache_clear — not in this version, safe to skip
-    
-    // Prefill
-    llama_batch batch = llama_batch_get_one(toks.data(), n);
-    if (llama_decode(g_ctx, batch) != 0) {
-        LOGE("Prefill failed"); return;
+// [ hint | open | text | tail ]: everything a turn adds before the answer.
+// The head and the hint end in a newline, so they tokenize on their own;
+// open, text and the plain start of tail ("Text: \"...\"") are tokenized
+// together, as quotes and punctuation would merge across a split. Empty if
+// text is blank. n_hint, if given, receives the number of hint tokens.
+static std::vector<llama_token> turn_tokens(const PromptParts& pp, const std::string& hint,
+                                            const std::string& text, int* n_hint = nullptr) {
+    if (text.find_first_not_of(" \t\n") == std::string::npos) return {};
+    std::vector<llama_token> toks;
+    if (!hint.empty()) toks = tokenize(hint, false, false);
+    if (n_hint) *n_hint = (int)toks.size();
+    const std::vector<llama_token> body = tokenize(pp.body_open + text + pp.body_close, false, false);
+    toks.reserve(toks.size() + body.size() + pp.tail_rest.size());
+    toks.insert(toks.end(), body.begin(), body.end());
+    toks.insert(toks.end(), pp.tail_rest.begin(), pp.tail_rest.end());
+    return toks;
+}
+
+// Batch for decode_seq(), kept across calls so decoding token by token
+// doesn't allocate. Sized for the largest prefill chunk seen. Stage held.
+static llama_batch g_batch     = {};
+static int         g_batch_cap = 0;
+
+// Decodes toks into seq starting at pos, in chunks that shrink as the device
+// heats up; logits are requested for the last token only.
+static bool decode_seq(const llama_token* toks, int n, llama_seq_id seq, llama_pos pos) {
+    const int chunk = thermal_prefill_chunk();
+    if (chunk > g_batch_cap) {
+        if (g_batch_cap > 0) llama_batch_free(g_batch);
+        g_batch     = llama_batch_init(chunk, 0, 1);
+        g_batch_cap = chunk;
     }
+    llama_batch& batch = g_batch;
+    bool ok = true;
+    for (int i = 0; i < n && ok; i += chunk) {
+        const int m = std::min(chunk, n - i);
+        batch.n_tokens = m;
+        for (int j = 0; j < m; ++j) {
+            batch.token[j]     = toks[i + j];
+            batch.pos[j]       = pos + i + j;
+            batch.n_seq_id[j]  = 1;
+            batch.seq_id[j][0] = seq;
+            batch.logits[j]    = i + j == n - 1;
+        }
+        ok = llama_decode(g_ctx, batch) == 0;
+    }
+    return ok;
+}
+
+static bool decode_seq(const std::vector<llama_token>& toks, llama_seq_id seq, llama_pos pos) {
+    return decode_seq(toks.data(), (int)toks.size(), seq, pos);
+}
 
-    // Sampler chain
+static llama_sampler* make_sampler() {
     auto* smpl = llama_sampler_chain_init(llama_sampler_chain_default_params());
     llama_sampler_chain_add(smpl, llama_sampler_init_top_p(0.90f, 1));
     llama_sampler_chain_add(smpl, llama_sampler_init_temp(0.60f));
     llama_sampler_chain_add(smpl, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
+    return smpl;
+}
+
+// Streams the piece of tok through out, holding back bytes of a character
+// that a byte-fallback token has only started (the JNI side needs whole
+// UTF-8 characters). out keeps its capacity, so steady state allocates nothing.
+static void emit_piece(llama_token tok, std::string& pending, std::string& out,
+                       const std::function<void(const std::string&)>& on_token) {
+    const VocabTable& pieces = *g_tiers[g_tier].pieces;
+    const std::string_view piece = pieces.piece(tok);
+    if (pending.empty() && !(pieces.flag(tok) & (PIECE_INCOMPLETE | PIECE_EMPTY))) {
+        out.assign(piece.data(), piece.size());
+        on_token(out);
+        return;
+    }
+    pending.append(piece.data(), piece.size());
+    const size_t n = utf8_complete_prefix(pending);
+    if (n == 0) return;
+    out.assign(pending, 0, n);
+    pending.erase(0, n);
+    on_token(out);
+}
+
+// emit_piece() for text that is not a whole token's piece.
+static void emit_bytes(std::string_view s, std::string& pending, std::string& out,
+                       const std::function<void(const std::string&)>& on_token) {
+    pending.append(s.data(), s.size());
+    const size_t n = utf8_complete_prefix(pending);
+    if (n == 0) return;
+    out.assign(pending, 0, n);
+    pending.erase(0, n);
+    on_token(out);
+}
+
+static std::atomic<bool> g_output_rules { true };
+
+void llama_bridge_set_output_rules(bool enabled) {
+    g_output_rules = enabled;
+}
+
+// The start of an answer, held back while it may still be a preamble, and
+// the quote pair around it.
+struct AnswerStart {
+    bool                     begun   = false;   // a token has been kept
+    bool                     holding = true;
+    std::vector<llama_token> held;
+    std::string              text;
+    bool                     lead    = true;    // only spaces released so far
+    int                      quote   = -1;      // pair whose opening was dropped
+    int                      depth   = 0;       // quote_scan() of the text since
+    std::string              closing;           // released text ending in its close
+};
+
+// emit_piece() past the preamble: drops an opening quote at the start, and
+// holds a piece ending in the matching close until the answer either ends
+// there (flush_answer) or goes on.
+static void release_piece(llama_token tok, AnswerStart& a, std::string& pending, std::string& out,
+                          const std::function<void(const std::string&)>& on_token) {
+    const LlamaTier& tier = g_tiers[g_tier];
+    if (!a.closing.empty()) {
+        emit_bytes(a.closing, pending, out, on_token);
+        a.closing.clear();
+        a.quote = -1;   // the outer pair closed early; what follows is kept as is
+    }
+    if (!a.lead && a.quote < 0) {
+        emit_piece(tok, pending, out, on_token);
+        return;
+    }
+    std::string_view body = tier.pieces->piece(tok);
+    std::string stripped;
+    if (a.lead) {
+        size_t lead = 0;
+        while (lead < body.size() && (body[lead] == ' ' || body[lead] == '\t')) ++lead;
+        if (lead == body.size()) {
+            emit_piece(tok, pending, out, on_token);
+            return;
+        }
+        a.lead  = false;
+        a.quote = quote_opening(*tier.rules, body.substr(lead));
+        if (a.quote < 0) {
+            emit_piece(tok, pending, out, on_token);
+            return;
+        }
+        stripped.assign(body.data(), lead);
+        const size_t n = tier.rules->quotes[a.quote].first.size();
+        stripped.append(body.data() + lead + n, body.size() - lead - n);
+        body = stripped;
+    }
+    const std::string& close = tier.rules->quotes[a.quote].second;
+    const bool ends_closed = body.size() >= close.size() &&
+                             body.compare(body.size() - close.size(), close.size(), close) == 0;
+    quote_scan(*tier.rules, a.quote, ends_closed ? body.substr(0, body.size() - close.size()) : body,
+               a.depth);
+    if (ends_closed && a.depth == 0) {
+        a.closing.assign(body.data(), body.size());
+        return;
+    }
+    if (ends_closed) quote_scan(*tier.rules, a.quote, close, a.depth);
+    if (a.depth < 0) a.quote = -1;
+    if (!body.empty()) emit_bytes(body, pending, out, on_token);
+}
+
+static void release_held(AnswerStart& a, std::string& pending, std::string& out,
+                         const std::function<void(const std::string&)>& on_token) {
+    for (llama_token tok : a.held) release_piece(tok, a, pending, out, on_token);
+    a.held.clear();
+    a.text.clear();
+    a.holding = false;
+}
+
+// At the end of the answer: releases what is held, without the closing quote
+// of the pair that opened it.
+static void flush_answer(AnswerStart& a, std::string& pending, std::string& out,
+                         const std::function<void(const std::string&)>& on_token) {
+    release_held(a, pending, out, on_token);
+    if (a.closing.empty()) return;
+    const size_t n = a.closing.size() - g_tiers[g_tier].rules->quotes[a.quote].second.size();
+    if (n > 0) emit_bytes(std::string_view(a.closing).substr(0, n), pending, out, on_token);
+    a.closing.clear();
+}
+
+// emit_piece() once the answer is known not to open with a preamble. A
+// preamble is dropped and the answer starts over after it (begun = false).
+// With the output rules off every piece goes straight through.
+static void emit_answer(llama_token tok, AnswerStart& a, std::string& pending, std::string& out,
+                        const std::function<void(const std::string&)>& on_token) {
+    const LlamaTier& tier = g_tiers[g_tier];
+    a.begun = true;
+    if (!g_output_rules) {
+        release_held(a, pending, out, on_token);
+        if (!a.closing.empty()) emit_bytes(a.closing, pending, out, on_token);
+        a.closing.clear();
+        emit_piece(tok, pending, out, on_token);
+        return;
+    }
+    if (!a.holding || tier.rules->openings.empty()) {
+        a.holding = false;
+        release_piece(tok, a, pending, out, on_token);
+        return;
+    }
+    const std::string_view piece = tier.pieces->piece(tok);
+    a.held.push_back(tok);
+    a.text.append(piece.data(), piece.size());
+    switch (preamble_check(*tier.rules, a.text)) {
+        case PREAMBLE_MAYBE:
+            break;
+        case PREAMBLE_FOUND:
+            LOGI("Preamble dropped: %s", a.text.c_str());
+            a = AnswerStart();
+            break;
+        case PREAMBLE_NONE:
+            release_held(a, pending, out, on_token);
+            break;
+    }
+}
+
+// ── Prefix snapshots ──────────────────────────────────────────────────────────
+//
+//  The KV state of a prompt head (the instruction for one language pair) is
+//  saved with llama_state_seq_save_file under <dir>/kv_<model>_<head>.bin,
+//  so after a restart or a language change the head is a file read instead
+//  of a prefill. The saved tokens are compared with the head on load, so a
+//  changed template or tokenizer can never restore stale state.
+//
+//  Every model, adapter and language pair adds a file, so the directory is
+//  capped at SNAPSHOT_MAX_BYTES: a restore touches its file's mtime, and a
+//  save evicts the least recently used files beyond the cap.
+
+static constexpr long long SNAPSHOT_MAX_BYTES = 64ll << 20;
+
+static std::string g_snapshot_dir;   // empty = snapshots off
+
+void llama_bridge_set_snapshot_dir(const char* dir) {
+    g_snapshot_dir = dir ? dir : "";
+}
+
+// Keyed by the weights in use: the tier's model plus its active adapter.
+static std::string snapshot_path(const std::string& head) {
+    if (g_snapshot_dir.empty()) return "";
+    const LlamaTier& tier = g_tiers[g_tier];
+    uint64_t weights = tier.fingerprint;
+    if (tier.active_adapter) weights = fnv1a(&tier.active_adapter, sizeof(uint64_t), weights);
+    char name[64];
+    snprintf(name, sizeof(name), "/kv_%016llx_%016llx.bin",
+             (unsigned long long)weights,
+             (unsigned long long)fnv1a(head.data(), head.size()));
+    return g_snapshot_dir + name;
+}
+
+// Deletes the least recently used snapshots until the rest fit the cap.
+static void snapshot_evict() {
+    DIR* d = opendir(g_snapshot_dir.c_str());
+    if (!d) return;
+    struct Entry { std::string path; time_t used; long long size; };
+    std::vector<Entry> files;
+    long long total = 0;
+    while (dirent* e = readdir(d)) {
+        if (strncmp(e->d_name, "kv_", 3) != 0) continue;
+        const std::string path = g_snapshot_dir + "/" + e->d_name;
+        struct stat sb {};
+        if (stat(path.c_str(), &sb) != 0) continue;
+        files.push_back({ path, sb.st_mtime, (long long)sb.st_size });
+        total += sb.st_size;
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end(),
+              [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& f : files) {
+        if (total <= SNAPSHOT_MAX_BYTES) break;
+        if (unlink(f.path.c_str()) != 0) continue;
+        total -= f.size;
+        LOGI("Snapshot evicted: %s", f.path.c_str());
+    }
+}
+
+// Fills seq from position 0 with toks (the head, rendered as key), from its
+// snapshot when one matches, otherwise by prefill (then saved). Returns the
+// token count, or -1 on failure. The sequence must be empty. Stage held.
+static int load_or_prefill_head(llama_seq_id seq, const std::string& head,
+                                const std::vector<llama_token>& toks) {
+    if (toks.empty()) return -1;
+
+    const std::string path = snapshot_path(head);
+    if (!path.empty()) {
+        std::vector<llama_token> saved(toks.size());
+        size_t n_saved = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        if (llama_state_seq_load_file(g_ctx, path.c_str(), seq, saved.data(), saved.size(), &n_saved) > 0 &&
+            saved == toks && n_saved == toks.size()) {
+            LOGI("Head restored from snapshot: %zu tokens in %.1f ms", toks.size(),
+                 std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            utime(path.c_str(), nullptr);   // most recently used
+            return (int)toks.size();
+        }
+        llama_memory_seq_rm(llama_get_memory(g_ctx), seq, -1, -1);
+    }
+
+    if (!decode_seq(toks, seq, 0)) return -1;
+    if (!path.empty()) {
+        if (llama_state_seq_save_file(g_ctx, path.c_str(), seq, toks.data(), toks.size()) == 0) {
+            LOGE("Failed to save snapshot: %s", path.c_str());
+        }
+        snapshot_evict();
+    }
+    return (int)toks.size();
+}
+
+// State that outlives a call: conversation heads cached per direction and the
+// rolling history; see their sections below.
+struct ConvDir {
+    std::string    head;
+    llama_context* ctx    = nullptr;   // context the head is cached in
+    llama_pos      n_head = 0;
+};
+
+struct History {
+    std::string     head;
+    llama_context*  ctx    = nullptr;
+    llama_pos       n_head = 0;
+    llama_pos       n_past = 0;
+    std::deque<int> turns;            // KV length of each resident turn, oldest first
+    EntityMap       ents;             // placeholders of the resident turns
+    std::deque<std::vector<int>> turn_ents;   // numbers each resident turn holds, same order
+};
+
+static ConvDir g_conv[CONV_DIRS];
+static History g_hist;
+
+// Clears the active context. Heads and history cached in it are lost.
+static void reset_memory() {
+    llama_memory_clear(llama_get_memory(g_ctx), true);
+    for (ConvDir& d : g_conv) {
+        if (d.ctx == g_ctx) d = ConvDir();
+    }
+    if (g_hist.ctx == g_ctx) g_hist = History();
+}
+
+// ── LoRA adapters ─────────────────────────────────────────────────────────────
+//
+//  Small per-pair adapters ride on the resident base model: a request for a
+//  pair with an adapter sets it on the context (llama_set_adapter_lora), any
+//  other request clears it. Nothing is reloaded, but KV entries computed
+//  under different weights are invalid, so a switch clears the context;
+//  heads then come back from their snapshots, which are keyed by model and
+//  adapter. A context holds one adapter set, so conversation directions with
+//  different adapters restore their heads at each change of speaker instead
+//  of keeping both resident.
+
+int llama_bridge_add_adapter(const std::string& src, const std::string& tgt, const char* path,
+                             const std::string& head, float scale) {
+    struct stat sb {};
+    stat(path, &sb);
+    const uint64_t v[] = { (uint64_t)sb.st_size, (uint64_t)sb.st_mtime };
+    uint64_t fp = fnv1a(v, sizeof(v), fnv1a(path, strlen(path)));
+    fp = fnv1a(&scale, sizeof(scale), fp);
+
+    // Tiers' contexts and adapter maps belong to the Llama stage
+    StageScope stage(STAGE_LLAMA);
+    const std::string key = pair_key(src, tgt);
+    int n = 0;
+    for (LlamaTier& t : g_tiers) {
+        auto it = t.loras.find(path);
+        llama_adapter_lora* lora = it != t.loras.end() ? it->second : nullptr;
+        if (!lora) {
+            // Fails for a model the adapter wasn't trained against
+            lora = llama_adapter_lora_init(t.model, path);
+            if (!lora) continue;
+            t.loras.emplace(path, lora);
+        }
+        t.adapters[key] = { lora, scale, head, fp };
+        t.prompts.erase(key);
+        ++n;
+    }
+    if (n == 0) LOGE("Adapter fits no tier: %s", path);
+    else        LOGI("Adapter %s → %s: %s on %d tier(s)", src.c_str(), tgt.c_str(), base_name(path), n);
+    return n;
+}
+
+void llama_bridge_clear_adapters() {
+    StageScope stage(STAGE_LLAMA);
+    llama_bridge_simul_end();
+    for (LlamaTier& t : g_tiers) {
+        llama_clear_adapter_lora(t.ctx);
+        llama_memory_clear(llama_get_memory(t.ctx), true);
+        for (auto& l : t.loras) llama_adapter_lora_free(l.second);
+        t.loras.clear();
+        t.adapters.clear();
+        t.prompts.clear();
+        t.active_adapter = 0;
+    }
+    for (ConvDir& d : g_conv) d = ConvDir();
+    g_hist = History();
+}
+
+// The active tier's adapter for src → tgt, or null. Stage held.
+static const PairAdapter* find_adapter(const std::string& src, const std::string& tgt) {
+    const LlamaTier& tier = g_tiers[g_tier];
+    if (src.empty()) return nullptr;
+    auto it = tier.adapters.find(pair_key(src, tgt));
+    return it != tier.adapters.end() ? &it->second : nullptr;
+}
+
+// Sets the adapter for src → tgt on the active context, or none when the
+// pair has none or src is empty (raw prompts). Stage held.
+static void use_adapter(const std::string& src, const std::string& tgt) {
+    LlamaTier& tier = g_tiers[g_tier];
+    const PairAdapter* a = find_adapter(src, tgt);
+    const uint64_t fp = a ? a->fingerprint : 0;
+    if (fp == tier.active_adapter) return;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    llama_clear_adapter_lora(g_ctx);
+    if (a && llama_set_adapter_lora(g_ctx, a->lora, a->scale) != 0) {
+        LOGE("Failed to set adapter for %s → %s", src.c_str(), tgt.c_str());
+        a = nullptr;
+    }
+    tier.active_adapter = a ? fp : 0;
+    reset_memory();
+    LOGI("Adapter %s (%.1f ms)", a ? (src + " → " + tgt).c_str() : "none",
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+}
+
+// ── Target-script sampling ────────────────────────────────────────────────────
+//
+//  Translating into a language with its own script, only a small part of the
+//  vocabulary can appear (the script log line gives the count per model).
+//  sample() reads the logits of those ids alone and runs the sampler chain
+//  on that short candidate list, instead of filling, sorting and
+//  normalizing one entry per vocabulary token at every step.
+//
+//  The output projection itself still produces every logit: llama.cpp's
+//  graph has no hook for a reduced lm_head, and Gemma ties it to the input
+//  embeddings. Everything after it is restricted. That projection (vocab ×
+//  n_embd per token) is most of what a pruned head would save, so decode
+//  tok/s is unchanged apart from the sampler's share; no before/after
+//  figure has been taken on a device.
+//
+//  The same pass leaves out the tokens the template's output rules forbid
+//  (output_rules.h): a note after a newline is never sampled, so it costs
+//  neither a decode step nor TTS time.
+
+static std::atomic<bool> g_script_mask { true };
+
+void llama_bridge_set_script_mask(bool enabled) {
+    g_script_mask = enabled;
+}
+
+// Tokens the active tier may emit when translating into tgt (a language
+// name), or null for the whole vocabulary. Listed on first use. Stage held.
+static const std::vector<llama_token>* target_tokens(const std::string& tgt) {
+    const Script script = script_for_language(tgt);
+    if (!g_script_mask || script == SCRIPT_ANY) return nullptr;
+    LlamaTier& tier = g_tiers[g_tier];
+    auto it = tier.allowed.find(script);
+    if (it == tier.allowed.end()) {
+        it = tier.allowed.emplace(script, std::vector<llama_token>()).first;
+        script_mask_build(llama_model_get_vocab(tier.model), *tier.pieces, script, it->second);
+    }
+    return &it->second;
+}
+
+// llama_sampler_sample() over the allowed ids only (all ids when null),
+// minus those the output rules forbid (when on); at_start adds the ones that
+// may not open an answer. cur is scratch kept by the caller across steps.
+static llama_token sample(llama_sampler* smpl, const std::vector<llama_token>* allowed,
+                          bool at_start, std::vector<llama_token_data>& cur) {
+    const LlamaTier& tier  = g_tiers[g_tier];
+    const uint8_t*   flags = tier.rules->flags.data();
+    const uint8_t    mask  = !g_output_rules ? 0
+                           : at_start ? OUT_BANNED | OUT_BANNED_FIRST | OUT_STOP : OUT_BANNED;
+    const float*     logits = llama_get_logits_ith(g_ctx, -1);
+    const int n = allowed ? (int)allowed->size() : tier.pieces->size();
+    cur.clear();
+    for (int i = 0; i < n; ++i) {
+        const llama_token id = allowed ? (*allowed)[i] : i;
+        if (!(flags[id] & mask)) cur.push_back({ id, logits[id], 0.0f });
+    }
+    llama_token_data_array arr = { cur.data(), cur.size(), -1, false };
+    llama_sampler_apply(smpl, &arr);
+    const llama_token tok = arr.data[arr.selected].id;
+    llama_sampler_accept(smpl, tok);
+    return tok;
+}
+
+static bool ends_answer(const llama_vocab* vocab, const uint8_t* flags, llama_token tok) {
+    return llama_vocab_is_eog(vocab, tok) || (g_output_rules && (flags[tok] & OUT_STOP));
+}
+
+// Samples and decodes into seq from pos, streaming pieces to on_token until
+// EOG, a stop token, MAX_NEW_TOKENS or barge-in. allowed (may be null) limits
+// the tokens sampled. Returns the number of tokens decoded.
+static int generate(llama_seq_id seq, llama_pos pos, uint64_t epoch, StageScope& stage,
+                    const std::vector<llama_token>* allowed,
+                    const std::function<void(const std::string&)>& on_token) {
+    const llama_vocab* vocab = llama_model_get_vocab(g_model);
+    auto* smpl = make_sampler();
+
+    const uint8_t* flags = g_tiers[g_tier].rules->flags.data();
+
+    int  n_decoded = 0;
+    std::string pending, piece;
+    std::vector<llama_token_data> cur;
+    AnswerStart answer;
+    const auto t_decode = std::chrono::steady_clock::now();
+    for (int i = 0; i < MAX_NEW_TOKENS; ++i) {
+        if (barge_in_epoch() != epoch) {
+            LOGI("Preempted by barge-in after %d tokens", n_decoded);
+            break;
+        }
+        llama_token tok = sample(smpl, allowed, !answer.begun, cur);
+        if (ends_answer(vocab, flags, tok)) break;
 
-    char piece[256];
-    for (int i = 0; i < 512; ++i) {
-        llama_token tok = llama_sampler_sample(smpl, g_ctx, -1);
-        if (llama_vocab_is_eog(vocab, tok)) break;
+        emit_answer(tok, answer, pending, piece, on_token);
 
-        int len = llama_token_to_piece(vocab, tok, piece, sizeof(piece), 0, true);
-        if (len > 0) on_token(std::string(piece, len));
+        // TTS or Whisper may have started since the last token
+        if (stage.refresh()) use_threads(stage);
 
-        llama_batch next = llama_batch_get_one(&tok, 1);
-        if (llama_decode(g_ctx, next) != 0) break;
+        if (!decode_seq(&tok, 1, seq, pos++)) break;
+        ++n_decoded;
     }
+    // After a barge-in nobody reads the rest
+    if (barge_in_epoch() == epoch) flush_answer(answer, pending, piece, on_token);
+
+    const double decode_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t_decode).count();
+    thermal_report(STAGE_LLAMA, stage.n_threads(), n_decoded, decode_ms);
 
     llama_sampler_free(smpl);
+    return n_decoded;
+}
+
+// ── Entity placeholders ───────────────────────────────────────────────────────
+//
+//  Conversation and history turns give Llama the transcript with numbers,
+//  phone numbers, URLs and the like replaced by "§n" (entity_mask.h), and
+//  restore them, in the target's number format, as the output streams.
+//  History turns stay in the KV cache masked, so their placeholders keep
+//  their numbers while resident; a new turn's take numbers none of them
+//  holds, and an evicted turn's are given out again.
+//  Simultaneous sessions are left as is: their source arrives word by word,
+//  so an entity may still be incomplete when it is pushed.
+
+static std::atomic<bool> g_entity_mask { true };
+
+void llama_bridge_set_entity_mask(bool enabled) {
+    g_entity_mask = enabled;
+}
+
+// generate() with ents' placeholders restored in what reaches on_token.
+static int generate_restoring(EntityMap& ents, llama_seq_id seq, llama_pos pos, uint64_t epoch,
+                              StageScope& stage, const std::vector<llama_token>* allowed,
+                              const std::function<void(const std::string&)>& on_token) {
+    if (ents.values.empty()) return generate(seq, pos, epoch, stage, allowed, on_token);
+    std::string text;
+    const int n = generate(seq, pos, epoch, stage, allowed, [&](const std::string& piece) {
+        entity_restore(ents, piece, text);
+        if (!text.empty()) on_token(text);
+    });
+    entity_restore_end(ents, barge_in_epoch() == epoch, text);
+    if (!text.empty()) on_token(text);
+    return n;
+}
+
+// ── Simultaneous (wait-k) translation ─────────────────────────────────────────
+//
+//  KV layout:  [ head | committed source ... | tail | committed output ... ]
+//                                           ^ src_end
+//
+//  New source words are spliced in at src_end: everything after it (the
+//  tail and the output emitted so far) is dropped and decoded again after
+//  the words, so each push costs the tail and output once more.
+//
+//  With the splice shift on (llama_bridge_set_simul_shift), the tail and
+//  output are instead moved up by the words' length (llama_memory_seq_add)
+//  and only the new words are decoded into the gap, plus the last token once
+//  more. That is an approximation, not an optimization of the same thing:
+//  the moved cells keep K/V computed without the new words, so later tokens
+//  attend to a tail and output that never saw them, and translations can
+//  differ. Off by default; needs K-shift support either way.
+//
+//  While the source is still open, output may run at most (source words - k)
+//  words. A token that would start a word past that limit is held back (not
+//  emitted, not decoded) and regenerated once more source commits.
+
+struct SimulState {
+    bool                     active      = false;
+    bool                     done        = false;   // EOG on final source
+    bool                     tail_in     = false;   // tail decoded after the source
+    int                      k           = 3;
+    int                      n_src_words = 0;
+    int                      n_out_words = 0;
+    llama_pos                src_end     = 0;
+    std::vector<llama_token> tail;
+    std::vector<llama_token> out;
+    std::string              pending;   // bytes of an unfinished character
+    AnswerStart              answer;
+    llama_sampler*           smpl        = nullptr;
+    const std::vector<llama_token>* allowed = nullptr;
+};
+
+static SimulState g_simul;
+
+static std::atomic<bool> g_simul_shift { false };
+
+void llama_bridge_set_simul_shift(bool enabled) {
+    g_simul_shift = enabled;
+}
+
+// Inserts src at src_end, leaving the logits of the sequence's last token
+// ready for sampling.
+static bool simul_splice(const std::vector<llama_token>& src) {
+    llama_memory_t  mem   = llama_get_memory(g_ctx);
+    const llama_pos n_src = (llama_pos)src.size();
+    const llama_pos end   = g_simul.src_end +
+                            (llama_pos)(g_simul.tail.size() + g_simul.out.size());
+
+    if (g_simul.tail_in && n_src == 0) return true;   // the last token's logits are still current
+
+    if (!g_simul.tail_in || !g_simul_shift || !llama_memory_can_shift(mem)) {
+        // Exact: everything after src_end is decoded again after src
+        llama_memory_seq_rm(mem, 0, g_simul.src_end, -1);
+        std::vector<llama_token> toks = src;
+        toks.insert(toks.end(), g_simul.tail.begin(), g_simul.tail.end());
+        toks.insert(toks.end(), g_simul.out.begin(),  g_simul.out.end());
+        const llama_pos at = g_simul.src_end;
+        g_simul.src_end += n_src;
+        g_simul.tail_in  = true;
+        return toks.empty() || decode_seq(toks, 0, at);
+    }
+    // Approximate: the moved cells keep their states from before src
+    const llama_token last = g_simul.out.empty() ? g_simul.tail.back() : g_simul.out.back();
+    llama_memory_seq_rm(mem, 0, end - 1, -1);
+    llama_memory_seq_add(mem, 0, g_simul.src_end, -1, n_src);
+    if (!decode_seq(src, 0, g_simul.src_end)) return false;
+    g_simul.src_end += n_src;
+    return decode_seq(&last, 1, 0, end - 1 + n_src);
+}
+
+bool llama_bridge_simul_begin(const std::string& src, const std::string& tgt, int k) {
+    if (g_tiers.empty()) return false;
+    thermal_tick();
+    StageScope stage(STAGE_LLAMA);
+    // The tier is fixed for the whole session: tokens are vocab-specific
+    select_tier((double)SIMUL_UNITS);
+    use_threads(stage);
+    use_adapter(src, tgt);
+    reset_memory();
+
+    // The source text grows in place, so the head runs up to its opening
+    const PromptParts& pp = prompt_parts(src, tgt);
+    std::vector<llama_token> head = pp.head_toks;
+    head.insert(head.end(), pp.open.begin(), pp.open.end());
+
+    if (g_simul.smpl) llama_sampler_free(g_simul.smpl);
+    g_simul         = SimulState();
+    g_simul.k       = k;
+    g_simul.tail    = pp.tail;
+    g_simul.smpl    = make_sampler();
+    g_simul.allowed = target_tokens(tgt);
+
+    const int n_head = load_or_prefill_head(0, pp.head + g_tiers[g_tier].tmpl->open, head);
+    if (n_head < 0) { LOGE("Simul prefill failed"); return false; }
+    g_simul.src_end = (llama_pos)n_head;
+    g_simul.active  = true;
+    LOGI("Simul session: head=%d tokens, wait-k=%d", n_head, k);
+    return true;
+}
+
+void llama_bridge_simul_push(const std::string& words, bool is_final,
+                             std::function<void(const std::string&)> on_token) {
+    if (!g_simul.active || g_simul.done) return;
+    const uint64_t epoch = barge_in_epoch();
+    thermal_tick();
+    StageScope stage(STAGE_LLAMA);
+    use_threads(stage);
+    const llama_vocab* vocab = llama_model_get_vocab(g_model);
+    const uint8_t*     flags = g_tiers[g_tier].rules->flags.data();
+
+    // words carries its own leading space (simulWords() in PipelineManager.kt)
+    std::vector<llama_token> src;
+    if (!words.empty()) {
+        src = tokenize(words, false, false);
+        g_simul.n_src_words += utf8_count_words(words);
+    }
+    if (!simul_splice(src)) { LOGE("Simul prefill failed"); g_simul.active = false; return; }
+
+    const int allowed = is_final ? INT32_MAX : g_simul.n_src_words - g_simul.k;
+    int n_decoded = 0;
+    std::string piece;
+    std::vector<llama_token_data> cur;
+    const auto t_decode = std::chrono::steady_clock::now();
+    while ((int)g_simul.out.size() < MAX_NEW_TOKENS) {
+        if (barge_in_epoch() != epoch) {
+            LOGI("Simul preempted by barge-in");
+            g_simul.done = true;
+            break;
+        }
+        llama_token tok = sample(g_simul.smpl, g_simul.allowed, !g_simul.answer.begun, cur);
+        if (ends_answer(vocab, flags, tok)) {
+            // On a partial source the model may just be out of material
+            if (is_final) g_simul.done = true;
+            break;
+        }
+
+        const bool starts_word = !g_simul.answer.begun ||
+                                 (g_tiers[g_tier].pieces->flag(tok) & PIECE_WORD_START);
+        if (starts_word && g_simul.n_out_words + 1 > allowed) break;   // hold back
+
+        emit_answer(tok, g_simul.answer, g_simul.pending, piece, on_token);
+        if (starts_word) ++g_simul.n_out_words;
+        // A dropped preamble gives its words back
+        if (!g_simul.answer.begun) g_simul.n_out_words = 0;
+        const llama_pos pos = g_simul.src_end +
+                              (llama_pos)(g_simul.tail.size() + g_simul.out.size());
+        g_simul.out.push_back(tok);
+
+        if (stage.refresh()) use_threads(stage);
+        if (!decode_seq(&tok, 1, 0, pos)) { g_simul.done = true; break; }
+        ++n_decoded;
+    }
+
+    const double decode_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t_decode).count();
+    thermal_report(STAGE_LLAMA, stage.n_threads(), n_decoded, decode_ms);
+    if (is_final) g_simul.done = true;
+    if (g_simul.done && barge_in_epoch() == epoch) {
+        flush_answer(g_simul.answer, g_simul.pending, piece, on_token);
+    }
+}
+
+void llama_bridge_simul_end() {
+    if (g_simul.smpl) llama_sampler_free(g_simul.smpl);
+    g_simul = SimulState();
+}
+
+// ── Two-way conversation ──────────────────────────────────────────────────────
+//
+//  Each direction (A→B, B→A) owns one sequence of the shared context:
+//
+//    seq 0:  [ head A→B | turn ... ]
+//    seq 1:  [ head B→A | turn ... ]
+//
+//  A turn trims its own sequence back to the end of the head and decodes from
+//  there, so the other direction's head stays cached and a change of speaker
+//  costs no prefill. A head is re-prefilled only when its text changes
+//  (languages picked again) or the tier selector moves to another context.
+
+// Makes sure dir's head is cached in the active context. Stage held.
+static bool conv_ensure_head(int dir, const PromptParts& pp) {
+    ConvDir& d = g_conv[dir];
+    if (d.ctx == g_ctx && d.head == pp.head) return true;
+    if (g_hist.ctx == g_ctx) reset_memory();   // history shares seq 0
+
+    llama_memory_seq_rm(llama_get_memory(g_ctx), dir, -1, -1);
+    d = ConvDir();
+    const int n_head = load_or_prefill_head(dir, pp.head, pp.head_toks);
+    if (n_head < 0) {
+        LOGE("Conversation head prefill failed (dir %d)", dir);
+        return false;
+    }
+    d.head   = pp.head;
+    d.ctx    = g_ctx;
+    d.n_head = (llama_pos)n_head;
+    LOGI("Conversation head cached: dir=%d, %d tokens", dir, n_head);
+    return true;
+}
+
+bool llama_bridge_conv_warm(int dir, const std::string& src, const std::string& tgt) {
+    if (g_tiers.empty() || dir < 0 || dir >= CONV_DIRS) return false;
+    StageScope stage(STAGE_LLAMA);
+    // A different adapter would clear the context, and with it the other
+    // direction's head; that direction's next turn is as likely as this one's
+    const PairAdapter* a = find_adapter(src, tgt);
+    if ((a ? a->fingerprint : 0) != g_tiers[g_tier].active_adapter &&
+        g_conv[1 - dir].ctx == g_ctx) {
+        LOGI("Conversation warm skipped (dir %d): other adapter", dir);
+        return false;
+    }
+    use_threads(stage);
+    use_adapter(src, tgt);
+    return conv_ensure_head(dir, prompt_parts(src, tgt));
+}
+
+void llama_bridge_conv_translate(int dir, const std::string& src, const std::string& tgt,
+                                 const std::string& hint, const std::string& text,
+                                 std::function<void(const std::string&)> on_token) {
+    if (g_tiers.empty() || dir < 0 || dir >= CONV_DIRS) return;
+    const uint64_t epoch = barge_in_epoch();
+    thermal_tick();
+    StageScope stage(STAGE_LLAMA);
+    const double units = text_units(hint) + text_units(text);
+    select_tier(units);
+    const auto t_start = std::chrono::steady_clock::now();
+    use_threads(stage);
+
+    // A simultaneous session on seq 0 would be overwritten below
+    if (g_simul.active) { llama_bridge_simul_end(); reset_memory(); }
+    use_adapter(src, tgt);
+    const PromptParts& pp = prompt_parts(src, tgt);
+    if (!conv_ensure_head(dir, pp)) return;
+
+    // Drop this direction's previous turn, keep its head
+    const llama_pos n_head = g_conv[dir].n_head;
+    llama_memory_seq_rm(llama_get_memory(g_ctx), dir, n_head, -1);
+
+    EntityMap ents;
+    const std::string masked = g_entity_mask ? entity_mask(text, src, tgt, ents) : text;
+    std::vector<llama_token> toks = turn_tokens(pp, hint, masked);
+    if (toks.empty() || !decode_seq(toks, dir, n_head)) { LOGE("Prefill failed"); return; }
+
+    generate_restoring(ents, dir, n_head + (llama_pos)toks.size(), epoch, stage,
+                       target_tokens(tgt), on_token);
+    tier_report(STAGE_LLAMA, g_tier, units,
+                std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t_start).count());
+}
+
+// ── Rolling history ───────────────────────────────────────────────────────────
+//
+//  KV layout (seq 0):  [ head | turn 1 | turn 2 | ... | turn n ]
+//  where a turn is     [ hint | open | source | tail | output | close ]
+//
+//  Each call appends one turn after the resident ones, so only its own tokens
+//  are prefilled while earlier turns still give the model context (pronouns,
+//  names, terminology). When the turn count or token budget is exceeded, the
+//  oldest turn is removed and the later ones are shifted down to close the
+//  gap. A new head (languages changed) or tier starts over. A turn's hint
+//  (similar earlier translation, required terms) is cut out once the turn is
+//  done, so it never reads as something that was said.
+
+static std::atomic<int> g_hist_max_turns  { 0 };
+static std::atomic<int> g_hist_max_tokens { 1024 };
+
+void llama_bridge_history_configure(int max_turns, int max_tokens) {
+    g_hist_max_turns  = max_turns;
+    g_hist_max_tokens = max_tokens;
+    LOGI("History: %d turns / %d tokens", max_turns, max_tokens);
+}
+
+// Drops the oldest resident turn. Stage held.
+static void hist_evict_oldest() {
+    llama_memory_t mem = llama_get_memory(g_ctx);
+    if (!llama_memory_can_shift(mem)) {
+        // Positions can't be moved: fall back to dropping all history
+        llama_memory_seq_rm(mem, 0, g_hist.n_head, -1);
+        g_hist.turns.clear();
+        g_hist.turn_ents.clear();
+        g_hist.ents   = EntityMap();
+        g_hist.n_past = g_hist.n_head;
+        return;
+    }
+    const int       len = g_hist.turns.front();
+    const llama_pos p0  = g_hist.n_head;
+    llama_memory_seq_rm (mem, 0, p0, p0 + len);
+    llama_memory_seq_add(mem, 0, p0 + len, -1, -len);
+    g_hist.turns.pop_front();
+    // Its placeholders are out of the cache: their numbers can be reused
+    entity_release(g_hist.ents, g_hist.turn_ents.front());
+    g_hist.turn_ents.pop_front();
+    g_hist.n_past -= len;
+}
+
+// Starts the history over if head or the active context changed. Stage held.
+static bool hist_ensure_head(const PromptParts& pp) {
+    if (g_hist.ctx == g_ctx && g_hist.head == pp.head) return true;
+    reset_memory();
+    const int n_head = load_or_prefill_head(0, pp.head, pp.head_toks);
+    if (n_head < 0) { LOGE("History head prefill failed"); return false; }
+    g_hist.head   = pp.head;
+    g_hist.ctx    = g_ctx;
+    g_hist.n_head = (llama_pos)n_head;
+    g_hist.n_past = g_hist.n_head;
+    return true;
+}
+
+bool llama_bridge_history_warm(const std::string& src, const std::string& tgt) {
+    if (g_tiers.empty()) return false;
+    StageScope stage(STAGE_LLAMA);
+    use_threads(stage);
+    if (g_simul.active) llama_bridge_simul_end();
+    use_adapter(src, tgt);
+    return hist_ensure_head(prompt_parts(src, tgt));
+}
+
+void llama_bridge_history_translate(const std::string& src, const std::string& tgt,
+                                    const std::string& hint, const std::string& text,
+                                    std::function<void(const std::string&)> on_token) {
+    if (g_tiers.empty()) return;
+    const uint64_t epoch = barge_in_epoch();
+    thermal_tick();
+    StageScope stage(STAGE_LLAMA);
+    const double units = text_units(hint) + text_units(text);
+    select_tier(units);
+    const auto t_start = std::chrono::steady_clock::now();
+    use_threads(stage);
+
+    if (g_simul.active) llama_bridge_simul_end();
+    use_adapter(src, tgt);
+    const PromptParts& pp = prompt_parts(src, tgt);
+    if (!hist_ensure_head(pp)) return;
+
+    // Make room for this turn at its longest
+    const std::vector<llama_token>& end = pp.close;
+    auto make_room = [&](size_t n_in) {
+        const int need = (int)(n_in + end.size()) + MAX_NEW_TOKENS;
+        while (!g_hist.turns.empty() &&
+               ((int)g_hist.turns.size() >= g_hist_max_turns ||
+                g_hist.n_past - g_hist.n_head > g_hist_max_tokens ||
+                g_hist.n_past + need > g_tiers[g_tier].n_ctx)) {
+            hist_evict_oldest();
+        }
+    };
+
+    // Evict against the unmasked turn before masking, so this turn's
+    // placeholders can take the numbers the evicted turns held
+    int n_hint = 0;
+    std::vector<llama_token> in = turn_tokens(pp, hint, text, &n_hint);
+    if (in.empty()) { LOGE("Tokenization failed"); return; }
+    make_room(in.size());
+    if (g_hist.turns.empty()) { g_hist.ents = EntityMap(); g_hist.turn_ents.clear(); }
+
+    EntityMap unmasked;
+    EntityMap& ents = g_entity_mask ? g_hist.ents : unmasked;
+    if (g_entity_mask) {
+        const std::string masked = entity_mask(text, src, tgt, ents);
+        if (!ents.current.empty()) {
+            in = turn_tokens(pp, hint, masked, &n_hint);
+            if (in.empty()) { LOGE("Tokenization failed"); entity_release(ents, ents.current); return; }
+            // A placeholder can tokenize longer than a short entity
+            make_room(in.size());
+        }
+    }
+
+    const llama_pos start = g_hist.n_past;
+    if (!decode_seq(in, 0, start)) { LOGE("Prefill failed"); g_hist = History(); return; }
+    const int n_out = generate_restoring(ents, 0, start + (llama_pos)in.size(), epoch, stage,
+                                         target_tokens(tgt), on_token);
+
+    if (g_hist_max_turns <= 0) {
+        // No history kept: only the head stays warm
+        llama_memory_seq_rm(llama_get_memory(g_ctx), 0, start, -1);
+        entity_release(ents, ents.current);
+    } else {
+        // Close the turn so the next one follows a well-formed exchange
+        const llama_pos close_at = start + (llama_pos)in.size() + n_out;
+        if (!end.empty() && !decode_seq(end, 0, close_at)) { g_hist = History(); return; }
+        g_hist.n_past = close_at + (llama_pos)end.size();
+        llama_memory_t mem = llama_get_memory(g_ctx);
+        if (n_hint > 0 && llama_memory_can_shift(mem)) {
+            llama_memory_seq_rm (mem, 0, start, start + n_hint);
+            llama_memory_seq_add(mem, 0, start + n_hint, -1, -n_hint);
+            g_hist.n_past -= n_hint;
+        } else if (n_hint > 0) {
+            // Positions can't be moved: don't keep the turn at all
+            llama_memory_seq_rm(mem, 0, start, -1);
+            g_hist.n_past = start;
+        }
+        if (g_hist.n_past > start) {
+            g_hist.turns.push_back((int)(g_hist.n_past - start));
+            g_hist.turn_ents.push_back(ents.current);
+        } else {
+            entity_release(ents, ents.current);
+        }
+    }
+
+    LOGI("History: %zu turns, %d tokens resident (+%zu prefilled)",
+         g_hist.turns.size(), (int)g_hist.n_past, in.size());
+    tier_report(STAGE_LLAMA, g_tier, units,
+                std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t_start).count());
 }
 
 void llama_bridge_free() {
-    if (g_ctx)   { llama_free(g_ctx);         g_ctx   = nullptr; }
-    if (g_model) { llama_model_free(g_model);  g_model = nullptr; }
+    llama_bridge_simul_end();
+    free_pool();
+    for (LlamaTier& t : g_tiers) {
+        llama_free(t.ctx);
+        for (auto& l : t.loras) llama_adapter_lora_free(l.second);
+        llama_model_free(t.model);
+    }
+    g_tiers.clear();
+    for (ConvDir& d : g_conv) d = ConvDir();
+    g_hist = History();
+    g_ctx   = nullptr;
+    g_model = nullptr;
+    if (g_batch_cap > 0) llama_batch_free(g_batch);
+    g_batch_cap = 0;
+    tier_clear(STAGE_LLAMA);
 }
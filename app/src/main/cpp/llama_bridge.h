@@ -3,6 +3,70 @@
 #include <functional>
 
 bool llama_bridge_init(const char* model_path, int n_threads, int n_ctx);
-void llama_bridge_translate(const std::string& prompt,
-                            std::function<void(const std::string&)> on_token);
+// Extra, faster tiers, added in order of decreasing quality after init.
+bool llama_bridge_add_tier(const char* model_path);
+// Counts translation turns waiting behind the current one (+1 queued, -1
+// taken or dropped); tier selection budgets for them as it does Whisper's for its scheduler queue.
+void llama_bridge_backlog_add(int delta);
+
+// The prompt-based calls below take language names (src, tgt) and build the
+// prompt from the model's template (prompt_templates.h). hint is optional
+// text placed before the source, e.g. a similar earlier translation.
+
+// Simultaneous (wait-k) translation. Source words are pushed as they commit,
+// and output is held to (source words - k) until the final push. words are
+// appended to the source as given, leading space included; scripts written
+// without spaces count a word per character (utf8_count_words).
+bool llama_bridge_simul_begin(const std::string& src, const std::string& tgt, int k);
+void llama_bridge_simul_push(const std::string& words, bool is_final,
+                             std::function<void(const std::string&)> on_token);
+void llama_bridge_simul_end();
+
+// Splices new source words in by shifting the tail and output instead of
+// decoding them again: faster per push, but approximate, since the shifted
+// states never saw the new words (default off).
+void llama_bridge_set_simul_shift(bool enabled);
+
+// Two-way conversation: direction 0/1 each keep their prompt head cached in
+// their own sequence, so alternating speakers never re-prefill it. Warming
+// returns false without work when the pair's adapter differs from the one
+// the other direction's resident head was computed under.
+bool llama_bridge_conv_warm(int dir, const std::string& src, const std::string& tgt);
+void llama_bridge_conv_translate(int dir, const std::string& src, const std::string& tgt,
+                                 const std::string& hint, const std::string& text,
+                                 std::function<void(const std::string&)> on_token);
+
+// Rolling history: the last max_turns turns (at most max_tokens) stay in the
+// KV cache after the head, and each call prefills only its own turn.
+// With max_turns == 0 each call stands alone but the head stays cached.
+void llama_bridge_history_configure(int max_turns, int max_tokens);
+bool llama_bridge_history_warm(const std::string& src, const std::string& tgt);
+void llama_bridge_history_translate(const std::string& src, const std::string& tgt,
+                                    const std::string& hint, const std::string& text,
+                                    std::function<void(const std::string&)> on_token);
+
+// LoRA adapter for src → tgt (language names), loaded against every tier
+// whose model it fits. Requests for the pair switch to it without reloading
+// the base. A non-empty head replaces the template's for the pair (adapters
+// trained on a shorter prompt). Returns the number of tiers it loaded on.
+int  llama_bridge_add_adapter(const std::string& src, const std::string& tgt, const char* path,
+                              const std::string& head, float scale);
+void llama_bridge_clear_adapters();
+
+// Restricts sampling to the target language's script (default on).
+void llama_bridge_set_script_mask(bool enabled);
+
+// Applies the prompt template's output rules (output_rules.h): stop at a
+// newline, drop a preamble and the quotes around the answer (default on).
+void llama_bridge_set_output_rules(bool enabled);
+
+// Replaces numbers, phone numbers, URLs etc. with placeholders in
+// conversation and history turns, restoring them in the output (default on).
+void llama_bridge_set_entity_mask(bool enabled);
+
+// Directory for per-model, per-head KV snapshots (empty = off). Heads are
+// restored from there instead of prefilled after a restart or language change;
+// the least recently used are deleted once the directory outgrows its cap.
+void llama_bridge_set_snapshot_dir(const char* dir);
+
 void llama_bridge_free();
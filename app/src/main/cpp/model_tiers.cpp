@@ -0,0 +1,106 @@
+#include "model_tiers.h"
+#include <android/log.h>
+#include <cstdio>
+#include <mutex>
+#include <sys/stat.h>
+#include <vector>
+
+#define TAG  "ModelTiers"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+static constexpr double EMA_ALPHA      = 0.3;
+static constexpr double UPGRADE_MARGIN = 0.8;
+
+struct Tier {
+    std::string name;
+    double      size_bytes;
+    double      ms_per_unit;   // 0 until observed
+};
+
+struct StageTiers {
+    std::vector<Tier> tiers;
+    int               slo_ms  = 0;   // 0 = always tier 0
+    int               current = 0;
+};
+
+static std::mutex g_mu;
+static StageTiers g_stage[STAGE_COUNT];
+
+// Caller holds g_mu.
+static double cost_of(const StageTiers& st, int i) {
+    const Tier& t = st.tiers[i];
+    if (t.ms_per_unit > 0.0) return t.ms_per_unit;
+    // Seed from any observed tier, scaled by relative model size
+    for (const Tier& o : st.tiers) {
+        if (o.ms_per_unit > 0.0 && o.size_bytes > 0.0) {
+            return o.ms_per_unit * t.size_bytes / o.size_bytes;
+        }
+    }
+    return 0.0;   // nothing observed yet: optimistic
+}
+
+void tier_configure(Stage stage, int slo_ms) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_stage[stage].slo_ms = slo_ms;
+    LOGI("Stage %d SLO: %d ms", (int)stage, slo_ms);
+}
+
+int tier_add(Stage stage, const char* name, const char* path) {
+    struct stat sb {};
+    const double size = stat(path, &sb) == 0 ? (double)sb.st_size : 0.0;
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_stage[stage].tiers.push_back({ name, size, 0.0 });
+    LOGI("Stage %d tier %zu: %s (%.0f MB)", (int)stage,
+         g_stage[stage].tiers.size() - 1, name, size / (1024.0 * 1024.0));
+    return (int)g_stage[stage].tiers.size() - 1;
+}
+
+int tier_select(Stage stage, double units, int queue_depth) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    StageTiers& st = g_stage[stage];
+    const int n = (int)st.tiers.size();
+    if (n <= 1 || st.slo_ms <= 0) return 0;
+
+    int pick = n - 1;   // fastest loaded tier if nothing fits
+    for (int i = 0; i < n; ++i) {
+        const double predicted = cost_of(st, i) * units * (1 + queue_depth);
+        const double budget    = i < st.current ? st.slo_ms * UPGRADE_MARGIN : st.slo_ms;
+        if (predicted <= budget) { pick = i; break; }
+    }
+    if (pick != st.current) {
+        LOGI("Stage %d: tier %s → %s (units=%.1f depth=%d)", (int)stage,
+             st.tiers[st.current].name.c_str(), st.tiers[pick].name.c_str(),
+             units, queue_depth);
+        st.current = pick;
+    }
+    return pick;
+}
+
+void tier_report(Stage stage, int tier, double units, double ms) {
+    if (units <= 0.0 || ms <= 0.0) return;
+    std::lock_guard<std::mutex> lk(g_mu);
+    StageTiers& st = g_stage[stage];
+    if (tier < 0 || tier >= (int)st.tiers.size()) return;
+    Tier& t = st.tiers[tier];
+    const double obs = ms / units;
+    t.ms_per_unit = t.ms_per_unit == 0.0 ? obs : EMA_ALPHA * obs + (1.0 - EMA_ALPHA) * t.ms_per_unit;
+}
+
+void tier_clear(Stage stage) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_stage[stage].tiers.clear();
+    g_stage[stage].current = 0;
+}
+
+std::string tier_status(Stage stage) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    const StageTiers& st = g_stage[stage];
+    if (st.tiers.empty()) return "-";
+    std::string out = st.tiers[st.current].name;
+    char buf[48];
+    for (size_t i = 0; i < st.tiers.size(); ++i) {
+        snprintf(buf, sizeof(buf), " [%zu:%.2f ms/u]", i, st.tiers[i].ms_per_unit);
+        out += buf;
+    }
+    return out;
+}
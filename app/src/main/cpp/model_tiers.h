@@ -0,0 +1,26 @@
+#pragma once
+#include "pipeline_stages.h"
+#include <string>
+
+// Latency-SLO-driven model tier selection.
+//
+// Each stage keeps an ordered list of loaded tiers, best quality first
+// (tier 0 is the model passed to init). A tier's cost is learned online as
+// ms per unit of work (audio seconds for Whisper, source characters for Llama);
+// untried tiers are seeded from the best tier's cost scaled by file size,
+// since decode on this class of device is memory-bandwidth bound.
+//
+// For each utterance the selector picks the best tier whose predicted
+// latency, multiplied by (1 + queue depth) to drain the backlog, fits the
+// SLO. Moving back up to a better tier needs 20% headroom to avoid flapping.
+// Only loaded tiers are ever candidates, so a switch is a pointer swap. That
+// residency has a price: Llama weights are mmapped, but every Llama tier
+// keeps its own KV cache, and whisper.cpp reads its weights into memory, so
+// each Whisper tier costs its full model size in RAM.
+
+void        tier_configure(Stage stage, int slo_ms);
+int         tier_add(Stage stage, const char* name, const char* path);
+int         tier_select(Stage stage, double units, int queue_depth);
+void        tier_report(Stage stage, int tier, double units, double ms);
+void        tier_clear(Stage stage);
+std::string tier_status(Stage stage);
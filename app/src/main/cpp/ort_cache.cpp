@@ -0,0 +1,175 @@
+#include "ort_cache.h"
+#include <android/log.h>
+#include <chrono>
+#include <mutex>
+
+#define TAG  "OrtCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#ifdef TRANSLATOR_ORT_C_API
+#include "onnxruntime/onnxruntime_c_api.h"
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+
+static std::mutex  g_mu;
+static std::string g_dir;
+static int         g_level = 99;
+// Models a build was started for; one that failed isn't retried until restart
+static std::unordered_set<std::string> g_tried;
+
+static uint64_t fnv1a(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+bool ort_cache_available() { return true; }
+
+void ort_cache_configure(const std::string& dir, int opt_level) {
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_dir   = dir;
+    g_level = opt_level;
+}
+
+// "<voice dir>-<path hash>-" for .../mms_tts/hin/model.onnx: every entry of
+// one model file, whatever its size, mtime, ORT version or level, starts
+// with it, and no other model's does.
+static std::string entry_prefix(const std::string& model) {
+    std::string name = model.substr(0, model.rfind('/'));
+    name = name.substr(name.rfind('/') + 1);
+    for (char& c : name) if (c == '-' || c == '.') c = '_';
+    char hash[24];
+    snprintf(hash, sizeof(hash), "-%016llx-", (unsigned long long)fnv1a(model.data(), model.size()));
+    return name + hash;
+}
+
+// Cache entry for model at level, or "" if model can't be stat'ed.
+static std::string entry_path(const std::string& dir, const std::string& model, int level) {
+    struct stat sb {};
+    if (stat(model.c_str(), &sb) != 0) return "";
+    const char* version = OrtGetApiBase()->GetVersionString();
+    const uint64_t v[] = { (uint64_t)sb.st_size, (uint64_t)sb.st_mtime, (uint64_t)level };
+    const uint64_t key = fnv1a(v, sizeof(v), fnv1a(version, strlen(version)));
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.onnx", (unsigned long long)key);
+    return dir + "/" + entry_prefix(model) + name;
+}
+
+// Removes the entries of the model prefix belongs to, except keep.
+static void drop_stale(const std::string& dir, const std::string& prefix, const std::string& keep) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    while (dirent* e = readdir(d)) {
+        const std::string path = dir + "/" + e->d_name;
+        if (strncmp(e->d_name, prefix.c_str(), prefix.size()) == 0 && path != keep) {
+            unlink(path.c_str());
+        }
+    }
+    closedir(d);
+}
+
+static bool ort_ok(const OrtApi* api, OrtStatus* status, const char* what) {
+    if (!status) return true;
+    LOGE("%s: %s", what, api->GetErrorMessage(status));
+    api->ReleaseStatus(status);
+    return false;
+}
+
+// Runs model through a session that writes its optimized graph to out.
+static bool optimize(const std::string& model, const std::string& out, int level) {
+    // Null when the runtime library is older than the header
+    const OrtApi* api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+    if (!api) {
+        LOGE("ONNX Runtime %s lacks API version %d", OrtGetApiBase()->GetVersionString(),
+             ORT_API_VERSION);
+        return false;
+    }
+    OrtEnv*            env  = nullptr;
+    OrtSessionOptions* opts = nullptr;
+    OrtSession*        sess = nullptr;
+
+    // One thread and no arena: the session is only created, never run
+    bool ok = ort_ok(api, api->CreateEnv(ORT_LOGGING_LEVEL_WARNING, TAG, &env), "CreateEnv") &&
+              ort_ok(api, api->CreateSessionOptions(&opts), "CreateSessionOptions") &&
+              ort_ok(api, api->SetSessionGraphOptimizationLevel(opts, (GraphOptimizationLevel)level),
+                     "SetSessionGraphOptimizationLevel") &&
+              ort_ok(api, api->SetIntraOpNumThreads(opts, 1), "SetIntraOpNumThreads") &&
+              ort_ok(api, api->DisableCpuMemArena(opts), "DisableCpuMemArena") &&
+              ort_ok(api, api->SetOptimizedModelFilePath(opts, out.c_str()),
+                     "SetOptimizedModelFilePath") &&
+              ort_ok(api, api->CreateSession(env, model.c_str(), opts, &sess), "CreateSession");
+
+    if (sess) api->ReleaseSession(sess);
+    if (opts) api->ReleaseSessionOptions(opts);
+    if (env)  api->ReleaseEnv(env);
+    return ok;
+}
+
+// Writes model's entry at path. On a thread of its own, at low priority.
+static void build(const std::string& model, const std::string& dir, const std::string& path,
+                  int level) {
+    setpriority(PRIO_PROCESS, 0, 10);
+    // Written under a temporary name so a crash never leaves a torn entry
+    mkdir(dir.c_str(), 0700);
+    const std::string tmp = path + ".tmp";
+    const auto t0 = std::chrono::steady_clock::now();
+    if (!optimize(model, tmp, level) || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        LOGE("Optimizing %s failed; it keeps loading as is", model.c_str());
+    } else {
+        drop_stale(dir, entry_prefix(model), path);
+        LOGI("Optimized %s (level %d) in %.0f ms; used from its next load", model.c_str(), level,
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+}
+
+std::string ort_cache_model(const std::string& model) {
+    std::string dir;
+    int level;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        dir   = g_dir;
+        level = g_level;
+    }
+    if (dir.empty()) return model;
+    const std::string path = entry_path(dir, model, level);
+    if (path.empty()) return model;
+    if (access(path.c_str(), R_OK) == 0) return path;
+
+    // Optimizing takes as long as a load or longer, so the voice loads as
+    // shipped now and the copy is built alongside; one build per model
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        if (!g_tried.insert(model).second) return model;
+    }
+    std::thread(build, model, dir, path, level).detach();
+    return model;
+}
+
+void ort_cache_drop(const std::string& model) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        dir = g_dir;
+    }
+    if (!dir.empty()) drop_stale(dir, entry_prefix(model), "");
+}
+
+#else   // no onnxruntime header: models load as shipped
+
+bool ort_cache_available() { return false; }
+
+void ort_cache_configure(const std::string&, int) {}
+
+std::string ort_cache_model(const std::string& model) { return model; }
+
+void ort_cache_drop(const std::string&) {}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+
+// Graph-optimized copies of the TTS voice models, so a voice load (warmup,
+// or a switch through the voice LRU) doesn't redo ONNX Runtime's graph
+// optimization every time.
+//
+// The first load of a model.onnx gets the model as shipped and starts a
+// background thread that runs it once through an ORT session with the
+// configured optimization level, keeping the optimized graph in the cache
+// directory, so warmup never waits on the pass. Later loads get that file
+// instead; ORT still walks the optimizer passes over it, but the fusions and
+// constant folding are already done. Entries are keyed by the source file's path, size and mtime, the
+// ORT version and the optimization level, so a replaced model or an ORT
+// upgrade builds a fresh one.
+//
+// Built only when the onnxruntime C API header is present (see
+// CMakeLists.txt); otherwise ort_cache_model() returns the model unchanged.
+
+bool ort_cache_available();
+
+// opt_level: 0 none, 1 basic, 2 extended, 99 all (ORT's GraphOptimizationLevel).
+// An empty dir disables the cache.
+void ort_cache_configure(const std::string& dir, int opt_level);
+
+// Path to load model from: its optimized copy, or model itself when the
+// copy isn't built yet (a build is started), the cache is off or
+// optimization failed.
+std::string ort_cache_model(const std::string& model);
+
+// Deletes model's optimized copy, e.g. after it failed to load.
+void ort_cache_drop(const std::string& model);
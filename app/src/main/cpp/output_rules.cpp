@@ -0,0 +1,112 @@
+#include "output_rules.h"
+#include <android/log.h>
+#include <chrono>
+#include <string_view>
+
+#define TAG  "OutputRules"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+
+// The UTF-8 characters of s, one string each.
+static std::vector<std::string> split_chars(const char* s) {
+    std::vector<std::string> out;
+    for (const char* p = s ? s : ""; *p; ) {
+        const unsigned char c = (unsigned char)*p;
+        size_t len = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : 4;
+        size_t n = 0;
+        while (n < len && p[n]) ++n;
+        out.emplace_back(p, n);
+        p += n;
+    }
+    return out;
+}
+
+static bool is_space(char c) { return c == ' ' || c == '\t'; }
+
+void output_rules_build(const llama_vocab* vocab, const VocabTable& pieces,
+                        const PromptTemplate& tmpl, OutputRules& out) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::vector<std::string> banned = split_chars(tmpl.banned);
+    const std::vector<std::string> first  = split_chars(tmpl.banned_first);
+    const std::vector<std::string> stop   = split_chars(tmpl.stop);
+
+    const int n = pieces.size();
+    out.flags.assign(n, 0);
+    int n_banned = 0;
+    for (llama_token tok = 0; tok < n; ++tok) {
+        if (llama_vocab_is_eog(vocab, tok) || llama_vocab_is_control(vocab, tok)) continue;
+        const std::string_view p = pieces.piece(tok);
+        uint8_t f = 0;
+        for (const std::string& c : banned) {
+            if (p.find(c) != std::string_view::npos) f |= OUT_BANNED;
+        }
+        // A stop character only ends the answer when it leads the piece;
+        // elsewhere it would cut off the text before it
+        for (const std::string& c : stop) {
+            const size_t at = p.find(c);
+            if (at == 0)                           f |= OUT_STOP;
+            else if (at != std::string_view::npos) f |= OUT_BANNED;
+        }
+        size_t lead = 0;
+        while (lead < p.size() && is_space(p[lead])) ++lead;
+        for (const std::string& c : first) {
+            if (p.compare(lead, c.size(), c) == 0) f |= OUT_BANNED_FIRST;
+        }
+        out.flags[tok] = f;
+        if (f & OUT_BANNED) ++n_banned;
+    }
+
+    out.openings.clear();
+    for (const char* const* o = tmpl.preambles; o && *o; ++o) out.openings.emplace_back(*o);
+    out.quotes.clear();
+    for (const char* const* q = tmpl.quotes; q && q[0] && q[1]; q += 2) {
+        out.quotes.emplace_back(q[0], q[1]);
+    }
+
+    LOGI("Output rules (%s): %d of %d tokens banned, %zu preamble openings (%.1f ms)",
+         tmpl.name, n_banned, n, out.openings.size(),
+         std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - t0).count());
+}
+
+PreambleState preamble_check(const OutputRules& rules, const std::string& text) {
+    std::string_view t = text;
+    while (!t.empty() && is_space(t.front())) t.remove_prefix(1);
+    if (t.empty()) return PREAMBLE_MAYBE;
+
+    bool maybe = false;
+    for (const std::string& o : rules.openings) {
+        if (t.size() < o.size()) {
+            if (o.compare(0, t.size(), t) == 0) maybe = true;
+        } else if (t.compare(0, o.size(), o) == 0) {
+            return PREAMBLE_FOUND;
+        }
+    }
+    return maybe ? PREAMBLE_MAYBE : PREAMBLE_NONE;
+}
+
+int quote_opening(const OutputRules& rules, std::string_view s) {
+    for (size_t q = 0; q < rules.quotes.size(); ++q) {
+        const std::string& open = rules.quotes[q].first;
+        if (s.compare(0, open.size(), open) == 0) return (int)q;
+    }
+    return -1;
+}
+
+void quote_scan(const OutputRules& rules, int q, std::string_view s, int& depth) {
+    const std::string& open  = rules.quotes[q].first;
+    const std::string& close = rules.quotes[q].second;
+    // With the same character for both, one inside the answer opens a quote
+    // when none is open and closes it otherwise
+    const bool same = open == close;
+    for (size_t i = 0; i < s.size(); ) {
+        if (s.compare(i, close.size(), close) == 0 && (!same || depth > 0)) {
+            --depth;
+            i += close.size();
+        } else if (s.compare(i, open.size(), open) == 0) {
+            ++depth;
+            i += open.size();
+        } else {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "llama.cpp/include/llama.h"
+#include "vocab_table.h"
+#include "prompt_templates.h"
+
+// Keeps the answer to the translation alone, from the template's output
+// constraints (prompt_templates.cpp).
+//
+// Token-level: tokens containing a banned character are never sampled, some
+// may not open the answer (a colon), and a stop character (newline) ends it,
+// so a trailing note or alternative is never generated. The flags are
+// computed once per vocabulary and template and applied in llama_bridge.cpp's
+// sample().
+//
+// Text-level: an answer is held back only while it is still a prefix of one
+// of the template's whole preambles ("Here is the translation:"), and
+// dropped once it completes one; anything else is released at its first
+// differing character. One pair of quotes around the whole answer is
+// dropped; quotes inside it are kept.
+
+enum OutputFlag : uint8_t {
+    OUT_BANNED       = 1 << 0,   // never sampled
+    OUT_BANNED_FIRST = 1 << 1,   // not as the first token of the answer
+    OUT_STOP         = 1 << 2,   // ends the answer once it has begun
+};
+
+struct OutputRules {
+    std::vector<uint8_t>     flags;      // per token
+    std::vector<std::string> openings;   // whole preambles, held back
+    std::vector<std::pair<std::string, std::string>> quotes;   // open, close
+};
+
+enum PreambleState {
+    PREAMBLE_MAYBE,   // keep holding
+    PREAMBLE_FOUND,   // drop what was held
+    PREAMBLE_NONE,    // release what was held
+};
+
+void output_rules_build(const llama_vocab* vocab, const VocabTable& pieces,
+                        const PromptTemplate& tmpl, OutputRules& out);
+
+// text: the answer so far (since its start or the last dropped preamble).
+PreambleState preamble_check(const OutputRules& rules, const std::string& text);
+
+// The pair whose opening quote s starts with, or -1.
+int  quote_opening(const OutputRules& rules, std::string_view s);
+
+// Follows the quotes of pair q in s: depth counts those opened inside the
+// answer and goes below 0 once the outer one is closed.
+void quote_scan(const OutputRules& rules, int q, std::string_view s, int& depth);
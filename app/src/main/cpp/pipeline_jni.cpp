@@ -1,9 +1,28 @@
 #include <jni.h>
 #include <string>
+#include <vector>
 #include "whisper_bridge.h"
 #include "llama_bridge.h"
+#include "pipeline_stages.h"
+#include "thread_budget.h"
+#include "thermal_monitor.h"
+#include "barge_in.h"
+#include "model_tiers.h"
+#include "translation_memory.h"
+#include "audio_cache.h"
+#include "tts_engine.h"
+#include "ort_cache.h"
+#include "glossary.h"
+#include "utterance_scheduler.h"
 #include "llama.cpp/ggml/include/ggml-cpu.h"
 
+static std::string jstring_to_std(JNIEnv* env, jstring s_j) {
+    const char* c = env->GetStringUTFChars(s_j, nullptr);
+    std::string s(c);
+    env->ReleaseStringUTFChars(s_j, c);
+    return s;
+}
+
 // ── Whisper ───────────────────────────────────────────────────────────────────
 
 extern "C" JNIEXPORT jboolean JNICALL
@@ -33,6 +52,15 @@ Java_com_example_speechtranslator_PipelineManager_nativeWhisperFree(
     whisper_bridge_free();
 }
 
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeWhisperAddTier(
+        JNIEnv* env, jobject, jstring path_j) {
+    const char* p = env->GetStringUTFChars(path_j, nullptr);
+    bool ok = whisper_bridge_add_tier(p);
+    env->ReleaseStringUTFChars(path_j, p);
+    return (jboolean)ok;
+}
+
 // ── Llama ─────────────────────────────────────────────────────────────────────
 
 extern "C" JNIEXPORT jboolean JNICALL
@@ -44,29 +72,537 @@ Java_com_example_speechtranslator_PipelineManager_nativeLlamaInit(
     return (jboolean)ok;
 }
 
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaAddTier(
+        JNIEnv* env, jobject, jstring path_j) {
+    const char* p = env->GetStringUTFChars(path_j, nullptr);
+    bool ok = llama_bridge_add_tier(p);
+    env->ReleaseStringUTFChars(path_j, p);
+    return (jboolean)ok;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSimulBegin(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jint k) {
+    return (jboolean)llama_bridge_simul_begin(jstring_to_std(env, src_j),
+                                              jstring_to_std(env, tgt_j), (int)k);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSimulPush(
+        JNIEnv* env, jobject, jstring words_j, jboolean is_final, jobject cb_obj) {
+    const char* wc = env->GetStringUTFChars(words_j, nullptr);
+    std::string words(wc);
+    env->ReleaseStringUTFChars(words_j, wc);
+
+    jclass    cls   = env->GetObjectClass(cb_obj);
+    jmethodID onTok = env->GetMethodID(cls, "onToken", "(Ljava/lang/String;)V");
+
+    llama_bridge_simul_push(words, is_final != 0, [&](const std::string& tok) {
+        jstring js = env->NewStringUTF(tok.c_str());
+        env->CallVoidMethod(cb_obj, onTok, js);
+        env->DeleteLocalRef(js);
+    });
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaConvWarm(
+        JNIEnv* env, jobject, jint dir, jstring src_j, jstring tgt_j) {
+    return (jboolean)llama_bridge_conv_warm((int)dir, jstring_to_std(env, src_j),
+                                            jstring_to_std(env, tgt_j));
+}
+
 extern "C" JNIEXPORT void JNICALL
-Java_com_example_speechtranslator_PipelineManager_nativeLlamaTranslate(
-        JNIEnv* env, jobject, jstring prompt_j, jobject cb_obj) {
-    const char* pc = env->GetStringUTFChars(prompt_j, nullptr);
-    std::string prompt(pc);
-    env->ReleaseStringUTFChars(prompt_j, pc);
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaConvTranslate(
+        JNIEnv* env, jobject, jint dir, jstring src_j, jstring tgt_j,
+        jstring hint_j, jstring text_j, jobject cb_obj) {
+    const std::string src  = jstring_to_std(env, src_j);
+    const std::string tgt  = jstring_to_std(env, tgt_j);
+    const std::string hint = jstring_to_std(env, hint_j);
+    const std::string text = jstring_to_std(env, text_j);
 
     jclass    cls   = env->GetObjectClass(cb_obj);
     jmethodID onTok = env->GetMethodID(cls, "onToken", "(Ljava/lang/String;)V");
 
-    llama_bridge_translate(prompt, [&](const std::string& tok) {
+    llama_bridge_conv_translate((int)dir, src, tgt, hint, text, [&](const std::string& tok) {
         jstring js = env->NewStringUTF(tok.c_str());
         env->CallVoidMethod(cb_obj, onTok, js);
         env->DeleteLocalRef(js);
     });
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaHistoryConfigure(
+        JNIEnv*, jobject, jint max_turns, jint max_tokens) {
+    llama_bridge_history_configure((int)max_turns, (int)max_tokens);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaHistoryWarm(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j) {
+    return (jboolean)llama_bridge_history_warm(jstring_to_std(env, src_j),
+                                               jstring_to_std(env, tgt_j));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaHistoryTranslate(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j,
+        jstring hint_j, jstring text_j, jobject cb_obj) {
+    const std::string src  = jstring_to_std(env, src_j);
+    const std::string tgt  = jstring_to_std(env, tgt_j);
+    const std::string hint = jstring_to_std(env, hint_j);
+    const std::string text = jstring_to_std(env, text_j);
+
+    jclass    cls   = env->GetObjectClass(cb_obj);
+    jmethodID onTok = env->GetMethodID(cls, "onToken", "(Ljava/lang/String;)V");
+
+    llama_bridge_history_translate(src, tgt, hint, text, [&](const std::string& tok) {
+        jstring js = env->NewStringUTF(tok.c_str());
+        env->CallVoidMethod(cb_obj, onTok, js);
+        env->DeleteLocalRef(js);
+    });
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSimulEnd(
+        JNIEnv*, jobject) {
+    llama_bridge_simul_end();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSetSnapshotDir(
+        JNIEnv* env, jobject, jstring dir_j) {
+    const char* d = env->GetStringUTFChars(dir_j, nullptr);
+    llama_bridge_set_snapshot_dir(d);
+    env->ReleaseStringUTFChars(dir_j, d);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSetScriptMask(
+        JNIEnv*, jobject, jboolean enabled) {
+    llama_bridge_set_script_mask(enabled != 0);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaBacklogAdd(
+        JNIEnv*, jobject, jint delta) {
+    llama_bridge_backlog_add(delta);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSetSimulShift(
+        JNIEnv*, jobject, jboolean enabled) {
+    llama_bridge_set_simul_shift(enabled != 0);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSetOutputRules(
+        JNIEnv*, jobject, jboolean enabled) {
+    llama_bridge_set_output_rules(enabled != 0);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaSetEntityMask(
+        JNIEnv*, jobject, jboolean enabled) {
+    llama_bridge_set_entity_mask(enabled != 0);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaAddAdapter(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jstring path_j, jstring head_j,
+        jfloat scale) {
+    const std::string path = jstring_to_std(env, path_j);
+    return (jint)llama_bridge_add_adapter(jstring_to_std(env, src_j), jstring_to_std(env, tgt_j),
+                                          path.c_str(), jstring_to_std(env, head_j), (float)scale);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeLlamaClearAdapters(
+        JNIEnv*, jobject) {
+    llama_bridge_clear_adapters();
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_example_speechtranslator_PipelineManager_nativeLlamaFree(
         JNIEnv*, jobject) {
     llama_bridge_free();
 }
 
+// ── Stages / thread budget ────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeBudgetSetMax(
+        JNIEnv*, jobject, jint stage, jint max_threads) {
+    budget_set_max((Stage)stage, (int)max_threads);
+}
+
+// For stages driven from Kotlin (TTS): marks the stage active so the budget
+// shrinks the others, and pins the calling thread. Returns the thread count.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeStageEnter(
+        JNIEnv*, jobject, jint stage) {
+    return (jint)stage_enter((Stage)stage);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeStageExit(
+        JNIEnv*, jobject, jint stage) {
+    stage_exit((Stage)stage);
+}
+
+// ── Thermal ───────────────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeThermalStatus(
+        JNIEnv* env, jobject) {
+    ThermalStatus st = thermal_status();
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             "level=%d | temp=%.1fC | llama=%.1f/%.1f tok/s | whisper=%.1fx RT",
+             st.level, st.temp_mc / 1000.0f,
+             st.llama_tok_s, st.llama_best_tok_s, st.whisper_rtf);
+    return env->NewStringUTF(buf);
+}
+
+// ── Model tiers ───────────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTierConfigure(
+        JNIEnv*, jobject, jint stage, jint slo_ms) {
+    tier_configure((Stage)stage, (int)slo_ms);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTierStatus(
+        JNIEnv* env, jobject, jint stage) {
+    return env->NewStringUTF(tier_status((Stage)stage).c_str());
+}
+
+// ── Translation memory ────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTmOpen(
+        JNIEnv* env, jobject, jstring path_j, jint data_bytes, jint n_slots) {
+    const char* p = env->GetStringUTFChars(path_j, nullptr);
+    bool ok = tm_open(p, (uint32_t)data_bytes, (uint32_t)n_slots);
+    env->ReleaseStringUTFChars(path_j, p);
+    return (jboolean)ok;
+}
+
+// Returns the stored translation, or null on a miss.
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTmLookup(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jstring text_j) {
+    std::string out;
+    if (!tm_lookup(jstring_to_std(env, src_j), jstring_to_std(env, tgt_j),
+                   jstring_to_std(env, text_j), out)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(out.c_str());
+}
+
+// Returns [normalized source, translation, score, same numbers "1"/"0"], or
+// null below min_score.
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTmFuzzyLookup(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jstring text_j, jfloat min_score) {
+    TmFuzzyHit hit;
+    if (!tm_fuzzy_lookup(jstring_to_std(env, src_j), jstring_to_std(env, tgt_j),
+                         jstring_to_std(env, text_j), (float)min_score, hit)) {
+        return nullptr;
+    }
+    char score[16];
+    snprintf(score, sizeof(score), "%.3f", hit.score);
+    jobjectArray out = env->NewObjectArray(4, env->FindClass("java/lang/String"), nullptr);
+    const char* parts[] = { hit.source.c_str(), hit.translation.c_str(), score,
+                            hit.same_numbers ? "1" : "0" };
+    for (int i = 0; i < 4; ++i) {
+        jstring js = env->NewStringUTF(parts[i]);
+        env->SetObjectArrayElement(out, i, js);
+        env->DeleteLocalRef(js);
+    }
+    return out;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTmPut(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jstring text_j, jstring tr_j) {
+    tm_put(jstring_to_std(env, src_j), jstring_to_std(env, tgt_j),
+           jstring_to_std(env, text_j), jstring_to_std(env, tr_j));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTmClose(
+        JNIEnv*, jobject) {
+    tm_close();
+}
+
+// [hits, misses, puts, bytes_used]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeTmStats(
+        JNIEnv* env, jobject) {
+    TmStats st = tm_stats();
+    const jlong v[] = { st.hits, st.misses, st.puts, st.bytes_used };
+    jlongArray out = env->NewLongArray(4);
+    env->SetLongArrayRegion(out, 0, 4, v);
+    return out;
+}
+
+// ── Glossary ──────────────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeGlossaryLoad(
+        JNIEnv* env, jobject, jstring path_j) {
+    return (jint)glossary_load(jstring_to_std(env, path_j).c_str());
+}
+
+// The mandated translation when one phrasebook entry is the whole
+// transcript, else null.
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeGlossaryLookup(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jstring text_j) {
+    std::vector<GlossaryHit> hits;
+    if (!glossary_match(jstring_to_std(env, src_j), jstring_to_std(env, tgt_j),
+                        jstring_to_std(env, text_j), hits)) {
+        return nullptr;
+    }
+    return env->NewStringUTF(hits[0].translation.c_str());
+}
+
+// [phrase, translation, phrase, translation, ...] in transcript order.
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeGlossaryTerms(
+        JNIEnv* env, jobject, jstring src_j, jstring tgt_j, jstring text_j) {
+    std::vector<GlossaryHit> hits;
+    glossary_match(jstring_to_std(env, src_j), jstring_to_std(env, tgt_j),
+                   jstring_to_std(env, text_j), hits);
+    jobjectArray out = env->NewObjectArray((jsize)hits.size() * 2,
+                                           env->FindClass("java/lang/String"), nullptr);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        const char* parts[] = { hits[i].phrase.c_str(), hits[i].translation.c_str() };
+        for (int j = 0; j < 2; ++j) {
+            jstring js = env->NewStringUTF(parts[j]);
+            env->SetObjectArrayElement(out, (jsize)(i * 2 + j), js);
+            env->DeleteLocalRef(js);
+        }
+    }
+    return out;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeGlossaryClear(
+        JNIEnv*, jobject) {
+    glossary_clear();
+}
+
+// ── TTS audio cache ───────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeAudioCacheConfigure(
+        JNIEnv* env, jobject, jint mem_bytes, jstring dir_j, jlong disk_bytes) {
+    ac_configure((size_t)mem_bytes, jstring_to_std(env, dir_j).c_str(), (size_t)disk_bytes);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeAudioCacheKey(
+        JNIEnv* env, jobject, jstring text_j, jstring voice_j,
+        jfloat length_scale, jfloat noise_scale, jfloat noise_scale_w, jfloat speed) {
+    return (jlong)ac_key(jstring_to_std(env, text_j), jstring_to_std(env, voice_j),
+                         length_scale, noise_scale, noise_scale_w, speed);
+}
+
+// Returns the cached samples, or null on a miss.
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeAudioCacheLookup(
+        JNIEnv* env, jobject, jlong key) {
+    std::vector<float> pcm;
+    if (!ac_lookup((uint64_t)key, pcm)) return nullptr;
+    jfloatArray out = env->NewFloatArray((jsize)pcm.size());
+    env->SetFloatArrayRegion(out, 0, (jsize)pcm.size(), pcm.data());
+    return out;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeAudioCachePut(
+        JNIEnv* env, jobject, jlong key, jfloatArray pcm_j) {
+    jsize   len = env->GetArrayLength(pcm_j);
+    jfloat* pcm = env->GetFloatArrayElements(pcm_j, nullptr);
+    ac_put((uint64_t)key, pcm, (int)len);
+    env->ReleaseFloatArrayElements(pcm_j, pcm, JNI_ABORT);
+}
+
+// [hits, disk_hits, misses, puts, mem_bytes, disk_bytes]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeAudioCacheStats(
+        JNIEnv* env, jobject) {
+    AcStats st = ac_stats();
+    const jlong v[] = { st.hits, st.disk_hits, st.misses, st.puts, st.mem_bytes, st.disk_bytes };
+    jlongArray out = env->NewLongArray(6);
+    env->SetLongArrayRegion(out, 0, 6, v);
+    return out;
+}
+
+// ── TTS engine ────────────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeTtsAvailable(
+        JNIEnv*, jobject) {
+    return (jboolean)tts_engine_available();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeTtsLoad(
+        JNIEnv* env, jobject, jstring voice_j, jstring model_j, jstring tokens_j, jstring lexicon_j,
+        jfloat length_scale, jfloat noise_scale, jfloat noise_scale_w, jint threads,
+        jint max_voices) {
+    TtsVoiceConfig cfg { jstring_to_std(env, model_j), jstring_to_std(env, tokens_j),
+                         jstring_to_std(env, lexicon_j), length_scale, noise_scale,
+                         noise_scale_w, (int)threads };
+    return (jboolean)tts_engine_load(jstring_to_std(env, voice_j), cfg, (int)max_voices);
+}
+
+// Calls cb.onChunk(handle, buffer, sampleRate) per chunk as synthesis
+// proceeds; Kotlin owns each clip. Returns the total samples, or -1 if the voice isn't loaded.
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeTtsSynthesizeStream(
+        JNIEnv* env, jobject, jstring voice_j, jstring text_j, jfloat speed, jobject cb_obj) {
+    jclass    cls     = env->GetObjectClass(cb_obj);
+    jmethodID onChunk = env->GetMethodID(cls, "onChunk", "(JLjava/nio/ByteBuffer;I)Z");
+
+    return (jint)tts_engine_synthesize_stream(
+            jstring_to_std(env, voice_j), jstring_to_std(env, text_j), speed,
+            [&](TtsClip* clip) {
+                jobject buf = env->NewDirectByteBuffer(clip->pcm.data(),
+                                                       (jlong)(clip->pcm.size() * sizeof(float)));
+                const bool more = env->CallBooleanMethod(cb_obj, onChunk, (jlong)(intptr_t)clip,
+                                                         buf, (jint)clip->sample_rate);
+                env->DeleteLocalRef(buf);
+                // No JNI call may follow a pending exception: stop, and let it
+                // reach Kotlin when this call returns
+                if (env->ExceptionCheck()) return false;
+                return more;
+            });
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeTtsClipFree(
+        JNIEnv*, jobject, jlong handle) {
+    tts_clip_free((TtsClip*)(intptr_t)handle);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeTtsRelease(
+        JNIEnv*, jobject) {
+    tts_engine_release();
+}
+
+// ── ONNX Runtime model cache ──────────────────────────────────────────────────
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeOrtCacheConfigure(
+        JNIEnv* env, jobject, jstring dir_j, jint opt_level) {
+    ort_cache_configure(jstring_to_std(env, dir_j), (int)opt_level);
+    return (jboolean)ort_cache_available();
+}
+
+// Path to load the model from; for the OfflineTts path (the native engine
+// resolves it itself in tts_engine_load).
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeOrtCacheModel(
+        JNIEnv* env, jobject, jstring model_j) {
+    return env->NewStringUTF(ort_cache_model(jstring_to_std(env, model_j)).c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_MmsTtsManager_nativeOrtCacheDrop(
+        JNIEnv* env, jobject, jstring model_j) {
+    ort_cache_drop(jstring_to_std(env, model_j));
+}
+
+// ── Barge-in ──────────────────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeBargeInConfigure(
+        JNIEnv*, jobject, jboolean enabled, jint min_gap_ms) {
+    barge_in_configure(enabled != 0, (int)min_gap_ms);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeBargeInSetBusy(
+        JNIEnv*, jobject, jboolean busy) {
+    barge_in_set_busy(busy != 0);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeBargeInOnSpeech(
+        JNIEnv*, jobject) {
+    return (jboolean)barge_in_on_speech_start();
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeBargeInEpoch(
+        JNIEnv*, jobject) {
+    return (jlong)barge_in_epoch();
+}
+
+// ── Utterance scheduler ───────────────────────────────────────────────────────
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeSchedConfigure(
+        JNIEnv*, jobject, jint capacity, jint max_wait_ms, jint wait_per_audio_s,
+        jint merge_max_samples, jint merge_gap_ms) {
+    SchedConfig cfg;
+    cfg.capacity          = (int)capacity;
+    cfg.max_wait_ms       = (int)max_wait_ms;
+    cfg.wait_per_audio_s  = (int)wait_per_audio_s;
+    cfg.merge_max_samples = (int)merge_max_samples;
+    cfg.merge_gap_ms      = (int)merge_gap_ms;
+    sched_configure(cfg);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeSchedSubmit(
+        JNIEnv* env, jobject, jfloatArray pcm_j, jint priority) {
+    jsize   len = env->GetArrayLength(pcm_j);
+    jfloat* pcm = env->GetFloatArrayElements(pcm_j, nullptr);
+    sched_submit(pcm, (int)len, (int)priority);
+    env->ReleaseFloatArrayElements(pcm_j, pcm, JNI_ABORT);
+}
+
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeSchedNext(
+        JNIEnv* env, jobject) {
+    std::vector<float> pcm;
+    if (!sched_next(pcm)) return nullptr;
+    jfloatArray out = env->NewFloatArray((jsize)pcm.size());
+    env->SetFloatArrayRegion(out, 0, (jsize)pcm.size(), pcm.data());
+    return out;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeSchedReset(
+        JNIEnv*, jobject) {
+    sched_reset();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeSchedClose(
+        JNIEnv*, jobject) {
+    sched_close();
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_speechtranslator_PipelineManager_nativeSchedStats(
+        JNIEnv* env, jobject) {
+    SchedStats st = sched_stats();
+    const jlong v[] = { st.submitted, st.started, st.merged,
+                        st.shed_expired, st.shed_overflow,
+                        st.queue_depth, st.max_wait_ms };
+    jlongArray out = env->NewLongArray(7);
+    env->SetLongArrayRegion(out, 0, 7, v);
+    return out;
+}
+
 // ── Backend info ──────────────────────────────────────────────────────────────
 
 extern "C" JNIEXPORT jstring JNICALL
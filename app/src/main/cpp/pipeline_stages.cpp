@@ -0,0 +1,90 @@
+#include "pipeline_stages.h"
+#include "thread_budget.h"
+#include <android/log.h>
+#include <atomic>
+#include <mutex>
+#include <sched.h>
+#include <unistd.h>
+
+#define TAG  "PipelineStages"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static std::mutex            g_cfg_mu;
+static std::mutex            g_stage_mu[STAGE_COUNT];
+static std::atomic<uint64_t> g_generation{0};
+static StageConfig           g_cfg[STAGE_COUNT] = {
+    { 4, 0 },   // Whisper
+    { 4, 0 },   // Llama
+    { 4, 0 },   // TTS
+};
+
+// A thread is inside at most one stage at a time.
+thread_local static cpu_set_t t_prev_mask;
+thread_local static bool      t_pinned     = false;
+thread_local static uint64_t  t_generation = 0;
+
+void stage_configure(Stage stage, int n_threads, uint64_t core_mask) {
+    if (stage < 0 || stage >= STAGE_COUNT) return;
+    std::lock_guard<std::mutex> lk(g_cfg_mu);
+    if (g_cfg[stage].n_threads == n_threads && g_cfg[stage].core_mask == core_mask) return;
+    if (n_threads > 0) g_cfg[stage].n_threads = n_threads;
+    g_cfg[stage].core_mask = core_mask;
+    g_generation.fetch_add(1, std::memory_order_release);
+    LOGI("Stage %d: threads=%d mask=0x%llx", (int)stage,
+         g_cfg[stage].n_threads, (unsigned long long)core_mask);
+}
+
+StageConfig stage_config(Stage stage) {
+    std::lock_guard<std::mutex> lk(g_cfg_mu);
+    return g_cfg[stage];
+}
+
+static void pin_current_thread(Stage stage, uint64_t core_mask) {
+    if (core_mask == 0) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    const long n_cpu = sysconf(_SC_NPROCESSORS_CONF);
+    for (int i = 0; i < 64 && i < n_cpu; ++i) {
+        if (core_mask & (1ull << i)) CPU_SET(i, &set);
+    }
+    if (CPU_COUNT(&set) == 0) return;
+
+    if (!t_pinned) {
+        if (sched_getaffinity(0, sizeof(t_prev_mask), &t_prev_mask) != 0) return;
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+        t_pinned = true;
+    } else {
+        LOGE("Stage %d: sched_setaffinity failed", (int)stage);
+    }
+}
+
+int stage_enter(Stage stage) {
+    g_stage_mu[stage].lock();
+    budget_enter(stage);
+    t_generation = g_generation.load(std::memory_order_acquire);
+    const StageConfig cfg = stage_config(stage);
+    pin_current_thread(stage, cfg.core_mask);
+    return cfg.n_threads;
+}
+
+bool stage_refresh(Stage stage, int* n_threads) {
+    const uint64_t gen = g_generation.load(std::memory_order_acquire);
+    if (gen == t_generation) return false;
+    t_generation = gen;
+    const StageConfig cfg = stage_config(stage);
+    pin_current_thread(stage, cfg.core_mask);
+    *n_threads = cfg.n_threads;
+    return true;
+}
+
+void stage_exit(Stage stage) {
+    if (t_pinned) {
+        sched_setaffinity(0, sizeof(t_prev_mask), &t_prev_mask);
+        t_pinned = false;
+    }
+    budget_leave(stage);
+    g_stage_mu[stage].unlock();
+}
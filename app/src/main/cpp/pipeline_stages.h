@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+// Pipeline stages that may run concurrently. Each stage owns a thread
+// count and a core mask so Whisper on utterance N+1 can overlap Llama on
+// utterance N without the two ggml thread groups fighting for cores.
+enum Stage {
+    STAGE_WHISPER = 0,
+    STAGE_LLAMA   = 1,
+    STAGE_TTS     = 2,
+    STAGE_COUNT
+};
+
+struct StageConfig {
+    int      n_threads;
+    uint64_t core_mask;   // bit i = cpu i; 0 = inherit, no pinning
+};
+
+void        stage_configure(Stage stage, int n_threads, uint64_t core_mask);
+StageConfig stage_config(Stage stage);
+
+// Enter/exit one stage call on the calling thread. Entering serializes
+// calls into the same stage (one context per stage) while letting different
+// stages run in parallel, marks the stage active in the thread budget, and
+// pins the calling thread to the stage's core mask. Returns the thread count.
+//
+// Pinning the caller reaches ggml's workers only where they are created by
+// it: ggml is built without OpenMP (CMakeLists.txt), so a graph computed
+// without an attached threadpool spawns its workers from the caller and
+// they inherit its mask. A persistent threadpool keeps the mask it was
+// created with and has to be pinned itself (Llama's, llama_bridge.cpp).
+int  stage_enter(Stage stage);
+// Re-reads the stage config if the budget changed since enter; re-pins and
+// returns true with the current thread count (the cores may have moved even
+// if the count didn't). Cheap enough to call per token.
+bool stage_refresh(Stage stage, int* n_threads);
+void stage_exit(Stage stage);
+
+class StageScope {
+public:
+    explicit StageScope(Stage stage) : stage_(stage), n_threads_(stage_enter(stage)) {}
+    ~StageScope() { stage_exit(stage_); }
+    StageScope(const StageScope&)            = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+    int  n_threads() const { return n_threads_; }
+    bool refresh()         { return stage_refresh(stage_, &n_threads_); }
+
+private:
+    Stage stage_;
+    int   n_threads_;
+};
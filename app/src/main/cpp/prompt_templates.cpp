@@ -0,0 +1,76 @@
+#include "prompt_templates.h"
+#include <android/log.h>
+#include <cstring>
+
+#define TAG  "PromptTemplates"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+
+#define INSTRUCTION "Translate the following {src} text to {tgt}. " \
+                    "Output only the translated {tgt} text, nothing else.\n\n"
+
+// What the models put around a translation: an explanation on the next
+// line, an introduction ending in a colon, the quotes copied from the prompt
+// around the whole answer. Quotes, brackets and markdown inside the answer
+// may be part of the translation and are kept.
+#define BANNED       ""
+#define BANNED_FIRST ":"
+#define STOP         "\n"
+
+static const char* const PREAMBLES[] = {
+    "Here is the translation:", "Here's the translation:",
+    "Sure, here is the translation:", "Sure, here's the translation:",
+    "The translation is:", "Translated text:", nullptr,
+};
+
+static const char* const QUOTES[] = {
+    "\"", "\"",   "“", "”",   "„", "“",   "«", "»",   "‘", "’",   nullptr,
+};
+
+static const PromptTemplate TEMPLATES[] = {
+    {
+        "gemma", "<start_of_turn>",
+        "<start_of_turn>user\n" INSTRUCTION,
+        "Text: \"",
+        "\"\n<end_of_turn>\n<start_of_turn>model\n",
+        "<end_of_turn>\n<start_of_turn>user\n",
+        BANNED, BANNED_FIRST, STOP, PREAMBLES, QUOTES,
+    },
+    {
+        "chatml", "<|im_start|>",
+        "<|im_start|>user\n" INSTRUCTION,
+        "Text: \"",
+        "\"<|im_end|>\n<|im_start|>assistant\n",
+        "<|im_end|>\n<|im_start|>user\n",
+        BANNED, BANNED_FIRST, STOP, PREAMBLES, QUOTES,
+    },
+    {
+        "llama3", "<|start_header_id|>",
+        "<|start_header_id|>user<|end_header_id|>\n\n" INSTRUCTION,
+        "Text: \"",
+        "\"<|eot_id|><|start_header_id|>assistant<|end_header_id|>\n\n",
+        "<|eot_id|><|start_header_id|>user<|end_header_id|>\n\n",
+        BANNED, BANNED_FIRST, STOP, PREAMBLES, QUOTES,
+    },
+};
+
+const PromptTemplate& prompt_template_for(const llama_model* model) {
+    const char* chat = llama_model_chat_template(model, nullptr);
+    for (const PromptTemplate& t : TEMPLATES) {
+        if (chat && strstr(chat, t.marker)) {
+            LOGI("Prompt template: %s", t.name);
+            return t;
+        }
+    }
+    LOGI("Prompt template: %s (no match in model metadata)", TEMPLATES[0].name);
+    return TEMPLATES[0];
+}
+
+std::string prompt_render(const char* part, const std::string& src, const std::string& tgt) {
+    std::string out;
+    for (const char* p = part; *p; ) {
+        if (strncmp(p, "{src}", 5) == 0)      { out += src; p += 5; }
+        else if (strncmp(p, "{tgt}", 5) == 0) { out += tgt; p += 5; }
+        else out += *p++;
+    }
+    return out;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include "llama.cpp/include/llama.h"
+
+// Translation prompt, per model family, split into the fixed parts that
+// surround the request text:
+//
+//   [ head | turn 1 | turn 2 | ... ]        head = instruction for the pair
+//   turn = [ hint | open | text | tail | output | close ]
+//
+// {src} and {tgt} in head are replaced by the language names. The parts are
+// tokenized once per model and language pair (llama_bridge.cpp); a request
+// tokenizes its hint, and its text together with open and the plain-text
+// start of tail, so every split falls on a newline or a control token. A
+// new model family needs only a new entry in the table in prompt_templates.cpp.
+//
+// The output fields constrain the answer (output_rules.h); null or empty
+// leaves it unconstrained.
+
+struct PromptTemplate {
+    const char* name;
+    const char* marker;   // identifies the family in the GGUF chat template
+    const char* head;
+    const char* open;     // before the source text
+    const char* tail;     // after it, up to where the model answers
+    const char* close;    // after the answer, ends the turn (rolling history)
+
+    const char*        banned;         // characters the answer never contains
+    const char*        banned_first;   // characters it may not open with
+    const char*        stop;           // characters that end it
+    const char* const* preambles;      // introductions, whole; null-terminated
+    const char* const* quotes;         // open, close, open, close ...; null-terminated
+};
+
+// The template whose marker appears in the model's chat template; the
+// first (Gemma) when none does.
+const PromptTemplate& prompt_template_for(const llama_model* model);
+std::string           prompt_render(const char* part, const std::string& src,
+                                    const std::string& tgt);
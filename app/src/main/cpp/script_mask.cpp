@@ -0,0 +1,91 @@
+#include "script_mask.h"
+#include <android/log.h>
+#include <chrono>
+
+#define TAG  "ScriptMask"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+
+struct Range { uint32_t lo, hi; };
+
+// Digits, punctuation, whitespace, symbols: allowed for every script
+static const Range COMMON[] = {
+    { 0x0000, 0x0040 }, { 0x005B, 0x0060 }, { 0x007B, 0x007F },
+    { 0x00A0, 0x00BF }, { 0x00D7, 0x00D7 }, { 0x00F7, 0x00F7 },
+    { 0x0964, 0x0965 },                      // danda, used across Indic scripts
+    { 0x2000, 0x206F }, { 0x20A0, 0x20CF },  // general punctuation (ZWJ/ZWNJ), currency
+};
+static const Range LATIN[]      = { { 0x0041, 0x005A }, { 0x0061, 0x007A },
+                                    { 0x00C0, 0x024F }, { 0x1E00, 0x1EFF } };
+static const Range DEVANAGARI[] = { { 0x0900, 0x097F }, { 0x1CD0, 0x1CFF }, { 0xA8E0, 0xA8FF } };
+static const Range TAMIL[]      = { { 0x0B80, 0x0BFF } };
+static const Range TELUGU[]     = { { 0x0C00, 0x0C7F } };
+static const Range ARABIC[]     = { { 0x0600, 0x06FF }, { 0x0750, 0x077F }, { 0x08A0, 0x08FF },
+                                    { 0xFB50, 0xFDFF }, { 0xFE70, 0xFEFF } };
+static const Range CJK[]        = { { 0x2E80, 0x2FDF }, { 0x3000, 0x303F }, { 0x3400, 0x4DBF },
+                                    { 0x4E00, 0x9FFF }, { 0xF900, 0xFAFF }, { 0xFF00, 0xFFEF },
+                                    { 0x20000, 0x2FFFF } };
+
+template <size_t N>
+static bool in(const Range (&ranges)[N], uint32_t cp) {
+    for (const Range& r : ranges) if (cp >= r.lo && cp <= r.hi) return true;
+    return false;
+}
+
+static bool in_script(Script s, uint32_t cp) {
+    if (in(COMMON, cp)) return true;
+    switch (s) {
+        case SCRIPT_LATIN:      return in(LATIN, cp);
+        case SCRIPT_DEVANAGARI: return in(DEVANAGARI, cp);
+        case SCRIPT_TAMIL:      return in(TAMIL, cp);
+        case SCRIPT_TELUGU:     return in(TELUGU, cp);
+        case SCRIPT_ARABIC:     return in(ARABIC, cp);
+        case SCRIPT_CJK:        return in(CJK, cp);
+        default:                return true;
+    }
+}
+
+Script script_for_language(const std::string& name) {
+    if (name == "Hindi" || name == "Marathi") return SCRIPT_DEVANAGARI;
+    if (name == "Tamil")   return SCRIPT_TAMIL;
+    if (name == "Telugu")  return SCRIPT_TELUGU;
+    if (name == "Arabic")  return SCRIPT_ARABIC;
+    if (name == "Chinese") return SCRIPT_CJK;
+    if (name == "English" || name == "French" || name == "Spanish" || name == "German") {
+        return SCRIPT_LATIN;
+    }
+    return SCRIPT_ANY;
+}
+
+// True if every whole character of p is allowed. Bytes of a character cut
+// off by the token boundary (byte-fallback tokens) are let through.
+static bool piece_allowed(std::string_view p, Script s) {
+    for (size_t i = 0; i < p.size(); ) {
+        const unsigned char c = (unsigned char)p[i];
+        int len = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3
+                : (c & 0xF8) == 0xF0 ? 4 : 0;
+        if (len == 0 || i + len > p.size()) return true;
+        uint32_t cp = len == 1 ? c : c & (0x7F >> len);
+        for (int k = 1; k < len; ++k) cp = (cp << 6) | ((unsigned char)p[i + k] & 0x3F);
+        if (!in_script(s, cp)) return false;
+        i += len;
+    }
+    return true;
+}
+
+void script_mask_build(const llama_vocab* vocab, const VocabTable& pieces, Script script,
+                       std::vector<llama_token>& allowed) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const int n = pieces.size();
+    allowed.clear();
+    for (llama_token tok = 0; tok < n; ++tok) {
+        bool ok;
+        if (llama_vocab_is_eog(vocab, tok))           ok = true;
+        else if (llama_vocab_is_control(vocab, tok))  ok = false;
+        else ok = !(pieces.flag(tok) & PIECE_EMPTY) && piece_allowed(pieces.piece(tok), script);
+        if (ok) allowed.push_back(tok);
+    }
+    allowed.shrink_to_fit();
+    LOGI("Script mask %d: %zu of %d tokens allowed (%.1f ms)", (int)script, allowed.size(), n,
+         std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - t0).count());
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "llama.cpp/include/llama.h"
+#include "vocab_table.h"
+
+// Restricts sampling to tokens written in the target language's script.
+//
+// A token is allowed if every character of its piece is in the script or
+// the shared set (digits, punctuation, whitespace), or if it ends
+// generation. The allowed ids are listed once per vocabulary and script;
+// the bridge reads logits for those ids only and samples among them
+// (llama_bridge.cpp, sample()).
+
+enum Script {
+    SCRIPT_ANY = 0,   // no restriction
+    SCRIPT_LATIN,
+    SCRIPT_DEVANAGARI,
+    SCRIPT_TAMIL,
+    SCRIPT_TELUGU,
+    SCRIPT_ARABIC,
+    SCRIPT_CJK,
+};
+
+// By English language name, as used in the prompt ("Hindi", "French").
+Script script_for_language(const std::string& name);
+
+// Allowed token ids, ascending.
+void script_mask_build(const llama_vocab* vocab, const VocabTable& pieces, Script script,
+                       std::vector<llama_token>& allowed);
@@ -0,0 +1,200 @@
+#include "thermal_monitor.h"
+#include "thread_budget.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TAG  "ThermalMonitor"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int   TEMP_LEVEL_MC[THERMAL_LEVEL_MAX] = { 65000, 75000, 85000 };
+static constexpr float TPUT_DROP_L1   = 0.75f;   // below 75% of best → level 1
+static constexpr float TPUT_DROP_L2   = 0.55f;   // below 55% of best → level 2
+static constexpr float EMA_ALPHA      = 0.3f;
+static constexpr int   SAMPLE_MS      = 1000;
+static constexpr int   COOLDOWN_MS    = 10000;
+static constexpr int   PREFILL_CHUNK[THERMAL_LEVEL_MAX + 1] = { 512, 256, 128, 64 };
+static constexpr int   MAX_THREADS    = 16;      // throughput is tracked per thread count up to this
+static constexpr int   FRESH_SAMPLES  = 3;       // reports at a count, since a level change, to judge it
+
+static std::mutex               g_mu;
+static int                      g_level   = 0;
+static int                      g_temp_mc = -1;
+// Per stage and thread count: a budget cut to fewer threads is slower by
+// design, so each count is compared only against its own best.
+static float                    g_tput[STAGE_COUNT][MAX_THREADS + 1] = {};
+static float                    g_best[STAGE_COUNT][MAX_THREADS + 1] = {};
+static int                      g_fresh[STAGE_COUNT][MAX_THREADS + 1] = {};   // reports since the level changed
+static int                      g_last_n[STAGE_COUNT] = { 0, 0, 0 };   // count of the latest report
+static Clock::time_point        g_last_sample;
+static Clock::time_point        g_below_since;
+static bool                     g_cooling = false;
+static int                    (*g_reader)() = nullptr;
+static int64_t                (*g_clock_ms)() = nullptr;
+static std::vector<std::string> g_zones;
+static bool                     g_zones_scanned = false;
+
+static bool is_cpu_zone(const char* type) {
+    static const char* keys[] = { "cpu", "soc", "tsens", "mtktscpu", "big", "little" };
+    for (const char* k : keys) {
+        if (strstr(type, k)) return true;
+    }
+    return false;
+}
+
+static void scan_zones() {
+    g_zones_scanned = true;
+    std::vector<std::string> all;
+    for (int i = 0; i < 64; ++i) {
+        char path[96], type[64] = {0};
+        snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/type", i);
+        FILE* f = fopen(path, "r");
+        if (!f) break;
+        if (!fgets(type, sizeof(type), f)) type[0] = 0;
+        fclose(f);
+
+        snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/temp", i);
+        all.emplace_back(path);
+        if (is_cpu_zone(type)) g_zones.emplace_back(path);
+    }
+    if (g_zones.empty()) g_zones = all;
+    LOGI("Thermal zones: %zu", g_zones.size());
+}
+
+// Hottest CPU zone in millidegrees, -1 if nothing is readable.
+static int read_sysfs_temp_mc() {
+    if (!g_zones_scanned) scan_zones();
+    int hottest = -1;
+    for (const auto& z : g_zones) {
+        FILE* f = fopen(z.c_str(), "r");
+        if (!f) continue;
+        int t = 0;
+        if (fscanf(f, "%d", &t) == 1) {
+            if (t > 0 && t < 1000) t *= 1000;   // some zones report whole degrees
+            hottest = std::max(hottest, t);
+        }
+        fclose(f);
+    }
+    return hottest;
+}
+
+static Clock::time_point now() {
+    return g_clock_ms ? Clock::time_point(std::chrono::milliseconds(g_clock_ms())) : Clock::now();
+}
+
+// Caller holds g_mu.
+static int target_level() {
+    int lvl = 0;
+    if (g_temp_mc >= 0) {
+        while (lvl < THERMAL_LEVEL_MAX && g_temp_mc >= TEMP_LEVEL_MC[lvl]) ++lvl;
+    }
+    // Throughput collapse means the governor is already clamping us. Only
+    // rates measured since the last level change count: an EMA left from a
+    // hot spell at this thread count would pull the level straight back up.
+    const int   n    = g_last_n[STAGE_LLAMA];
+    const float best = g_best[STAGE_LLAMA][n];
+    if (best > 0.0f && g_fresh[STAGE_LLAMA][n] >= FRESH_SAMPLES) {
+        const float ratio = g_tput[STAGE_LLAMA][n] / best;
+        if (ratio < TPUT_DROP_L2)      lvl = std::max(lvl, 2);
+        else if (ratio < TPUT_DROP_L1) lvl = std::max(lvl, 1);
+    }
+    return lvl;
+}
+
+// Rates measured under the old level no longer describe the new one; the
+// bests stay, they are what each count can do when cool. Caller holds g_mu.
+static void reset_rates() {
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        for (int n = 0; n <= MAX_THREADS; ++n) {
+            g_tput[s][n]  = 0.0f;
+            g_fresh[s][n] = 0;
+        }
+    }
+}
+
+// Step up at once; step down one level per cool-down period. Caller holds g_mu.
+static void apply_level(int target, Clock::time_point now) {
+    const int before = g_level;
+    if (target >= g_level) {
+        g_level   = target;
+        g_cooling = false;
+    } else if (!g_cooling) {
+        g_cooling     = true;
+        g_below_since = now;
+    } else if (now - g_below_since >= std::chrono::milliseconds(COOLDOWN_MS)) {
+        --g_level;
+        g_below_since = now;
+    }
+    if (g_level != before) reset_rates();
+}
+
+void thermal_tick() {
+    int lvl;
+    {
+        std::lock_guard<std::mutex> lk(g_mu);
+        const auto t = now();
+        if (t - g_last_sample < std::chrono::milliseconds(SAMPLE_MS)) return;
+        g_last_sample = t;
+
+        g_temp_mc = g_reader ? g_reader() : read_sysfs_temp_mc();
+        const int   before = g_level;
+        const int   n      = g_last_n[STAGE_LLAMA];
+        const float tput   = g_tput[STAGE_LLAMA][n];
+        apply_level(target_level(), t);
+        if (g_level == before) return;
+        lvl = g_level;
+        LOGW("Throttle level %d → %d (temp=%d mC, llama %.1f/%.1f tok/s on %d threads)", before, lvl,
+             g_temp_mc, tput, g_best[STAGE_LLAMA][n], n);
+    }
+    budget_set_throttle(lvl);
+}
+
+void thermal_report(Stage stage, int n_threads, double units, double ms) {
+    if (ms <= 0.0 || units <= 0.0) return;
+    const int n = std::min(std::max(n_threads, 1), MAX_THREADS);
+    std::lock_guard<std::mutex> lk(g_mu);
+    const float rate = (float)(units * 1000.0 / ms);
+    float& tput = g_tput[stage][n];
+    tput = tput == 0.0f ? rate : EMA_ALPHA * rate + (1.0f - EMA_ALPHA) * tput;
+    g_best[stage][n] = std::max(g_best[stage][n], tput);
+    ++g_fresh[stage][n];
+    g_last_n[stage] = n;
+}
+
+int thermal_level() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    return g_level;
+}
+
+ThermalStatus thermal_status() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    return { g_level, g_temp_mc,
+             g_tput[STAGE_LLAMA][g_last_n[STAGE_LLAMA]], g_best[STAGE_LLAMA][g_last_n[STAGE_LLAMA]],
+             g_tput[STAGE_WHISPER][g_last_n[STAGE_WHISPER]] };
+}
+
+int thermal_prefill_chunk() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    return PREFILL_CHUNK[g_level];
+}
+
+void thermal_set_reader(int (*read_temp_mc)()) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_reader      = read_temp_mc;
+    g_last_sample = Clock::time_point();
+}
+
+void thermal_set_clock(int64_t (*now_ms)()) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_clock_ms    = now_ms;
+    g_last_sample = Clock::time_point();
+    g_cooling     = false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "pipeline_stages.h"
+
+// Thermal-aware throttling of inference parallelism.
+//
+// Tracks rolling throughput per stage (Llama decode tok/s, Whisper
+// audio-seconds per second) and the hottest CPU thermal zone, and derives a
+// throttle level 0..3. Higher levels shrink every stage's thread budget and
+// the Llama prefill chunk, and from level 2 keep the prime core idle, so we
+// shed heat before the kernel governor clamps frequencies for us.
+//
+// Levels rise immediately and fall one step at a time after a cool-down.
+
+enum { THERMAL_LEVEL_MAX = 3 };
+
+struct ThermalStatus {
+    int   level;
+    int   temp_mc;         // millidegrees C, -1 if unknown
+    float llama_tok_s;     // rolling decode throughput at the current thread count
+    float llama_best_tok_s;// best seen at that thread count
+    float whisper_rtf;     // audio seconds per wall second
+};
+
+// Samples temperature (rate-limited) and updates the level. Call at the
+// start of each stage call; cheap when called often.
+void          thermal_tick();
+// units of work done in ms on n_threads threads; a drop is judged against
+// the best rate seen with the same thread count.
+void          thermal_report(Stage stage, int n_threads, double units, double ms);
+int           thermal_level();
+ThermalStatus thermal_status();
+// Prefill chunk for the current level (512 → 64 tokens).
+int           thermal_prefill_chunk();
+
+// Host tests inject readings here instead of /sys/class/thermal.
+// Pass nullptr to restore the sysfs reader.
+void          thermal_set_reader(int (*read_temp_mc)());
+// Host tests drive time here (milliseconds, any epoch) so a cool-down
+// doesn't take real seconds. Pass nullptr to restore the steady clock.
+void          thermal_set_clock(int64_t (*now_ms)());
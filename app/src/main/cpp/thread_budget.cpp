@@ -0,0 +1,110 @@
+#include "thread_budget.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+#define TAG  "ThreadBudget"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+static std::mutex       g_mu;
+static int              g_max[STAGE_COUNT] = { 4, 6, 4 };
+static unsigned         g_active  = 0;     // bit per Stage
+static int              g_throttle = 0;
+static std::vector<int> g_cores;           // cpu ids, slowest → fastest
+
+// Orders cores by /sys cpu_capacity; falls back to cpu id, which on
+// big.LITTLE Android kernels already runs little → big.
+static void discover_cores() {
+    const long n_cpu = std::min(64L, sysconf(_SC_NPROCESSORS_CONF));
+    std::vector<std::pair<int, int>> cap;   // (capacity, cpu)
+    bool have_capacity = true;
+    for (int i = 0; i < n_cpu; ++i) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", i);
+        int c = -1;
+        if (FILE* f = fopen(path, "r")) {
+            if (fscanf(f, "%d", &c) != 1) c = -1;
+            fclose(f);
+        }
+        if (c < 0) have_capacity = false;
+        cap.emplace_back(c, i);
+    }
+    if (have_capacity) std::stable_sort(cap.begin(), cap.end());
+    g_cores.clear();
+    for (auto& p : cap) g_cores.push_back(p.second);
+}
+
+// Caller holds g_mu.
+static void replan() {
+    const int n = std::max(1, (int)g_cores.size() - (g_throttle >= 2 ? 1 : 0));
+    int max_t[STAGE_COUNT];
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        max_t[s] = std::max(1, g_max[s] * (4 - g_throttle) / 4);
+    }
+
+    const bool w = g_active & (1u << STAGE_WHISPER);
+    const bool l = g_active & (1u << STAGE_LLAMA);
+    const bool t = g_active & (1u << STAGE_TTS);
+
+    int alloc[STAGE_COUNT] = { 0, 0, 0 };
+    int rem = n;
+    if (t) {
+        alloc[STAGE_TTS] = std::max(1, std::min(max_t[STAGE_TTS], n - (int)w - (int)l));
+        rem -= alloc[STAGE_TTS];
+    }
+    if (w && l) {
+        const int share = rem * max_t[STAGE_LLAMA] / (max_t[STAGE_LLAMA] + max_t[STAGE_WHISPER]);
+        alloc[STAGE_LLAMA]   = std::max(1, std::min(max_t[STAGE_LLAMA], share));
+        alloc[STAGE_WHISPER] = std::max(1, std::min(max_t[STAGE_WHISPER], rem - alloc[STAGE_LLAMA]));
+    } else if (l) {
+        alloc[STAGE_LLAMA]   = std::max(1, std::min(max_t[STAGE_LLAMA], rem));
+    } else if (w) {
+        alloc[STAGE_WHISPER] = std::max(1, std::min(max_t[STAGE_WHISPER], rem));
+    }
+
+    uint64_t mask[STAGE_COUNT] = { 0, 0, 0 };
+    int lo = 0, hi = n - 1;   // when throttled, g_cores.back() is left out
+    for (int i = 0; i < alloc[STAGE_TTS]     && lo <= hi; ++i) mask[STAGE_TTS]     |= 1ull << g_cores[lo++];
+    for (int i = 0; i < alloc[STAGE_LLAMA]   && lo <= hi; ++i) mask[STAGE_LLAMA]   |= 1ull << g_cores[hi--];
+    for (int i = 0; i < alloc[STAGE_WHISPER] && lo <= hi; ++i) mask[STAGE_WHISPER] |= 1ull << g_cores[hi--];
+
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        if (g_active & (1u << s)) stage_configure((Stage)s, alloc[s], mask[s]);
+    }
+}
+
+void budget_set_max(Stage stage, int max_threads) {
+    if (stage < 0 || stage >= STAGE_COUNT) return;
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (g_cores.empty()) discover_cores();
+    g_max[stage] = std::max(1, max_threads);
+    LOGI("Budget: %zu cores | max W=%d L=%d T=%d", g_cores.size(),
+         g_max[STAGE_WHISPER], g_max[STAGE_LLAMA], g_max[STAGE_TTS]);
+}
+
+void budget_set_throttle(int level) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_throttle = std::max(0, std::min(3, level));
+    if (g_active) replan();
+}
+
+void budget_enter(Stage stage) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (g_cores.empty()) discover_cores();
+    g_active |= 1u << stage;
+    replan();
+}
+
+void budget_leave(Stage stage) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_active &= ~(1u << stage);
+    if (g_active) replan();
+}
+
+int budget_total_cores() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    return (int)g_cores.size();
+}
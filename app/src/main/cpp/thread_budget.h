@@ -0,0 +1,22 @@
+#pragma once
+#include "pipeline_stages.h"
+
+// Global CPU budget shared by Whisper, Llama and TTS.
+//
+// The coordinator owns every core. Whenever a stage starts or finishes it
+// re-plans thread counts and disjoint core masks for the stages running
+// right now and pushes them through stage_configure(), so the sum of
+// threads never exceeds the core count. Llama grows from the fastest cores,
+// TTS from the slowest, Whisper takes the fastest cores Llama left over.
+//
+// TTS is a fixed reservation: ONNX Runtime sizes its intra-op pool once
+// at session creation, so it cannot shrink mid-synthesis like ggml can.
+
+// Upper bound on threads a stage may use when it runs alone.
+void budget_set_max(Stage stage, int max_threads);
+// Thermal throttle level 0..3: scales every stage's maximum down by 25%
+// per level, and from level 2 leaves the fastest (hottest) core idle.
+void budget_set_throttle(int level);
+void budget_enter(Stage stage);
+void budget_leave(Stage stage);
+int  budget_total_cores();
@@ -0,0 +1,514 @@
+#include "translation_memory.h"
+#include "utf8.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAG  "TranslationMemory"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static constexpr uint32_t TM_MAGIC   = 0x314D5454;   // "TTM1"
+static constexpr uint32_t TM_VERSION = 1;
+static constexpr int      MAX_PROBE  = 8;
+
+//  File layout:  [ TmHeader | TmSlot × n_slots | record area (data_bytes) ]
+//  Record:       [ TmRecord | key | translation | pad to 8 ]
+
+struct TmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_slots;
+    uint32_t data_bytes;
+    uint32_t head;       // next write offset in the record area
+    uint32_t wrapped;    // record area has wrapped at least once
+    uint32_t next_seq;   // 0 marks an empty slot, so starts at 1
+    uint32_t reserved;
+};
+
+struct TmSlot {
+    uint64_t hash;
+    uint32_t offset;
+    uint32_t seq;
+};
+
+struct TmRecord {
+    uint32_t seq;
+    uint32_t key_len;
+    uint32_t val_len;
+    uint32_t reserved;
+};
+
+static std::mutex g_mu;
+static int        g_fd       = -1;
+static uint8_t*   g_base     = nullptr;
+static size_t     g_map_size = 0;
+static TmHeader*  g_hdr      = nullptr;
+static TmSlot*    g_slots    = nullptr;
+static uint8_t*   g_data     = nullptr;
+static TmStats    g_stats    = {};
+
+static uint64_t fnv1a(const std::string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+    return h;
+}
+
+std::string tm_normalize(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    bool gap = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = (unsigned char)text[i];
+        // Devanagari danda / double danda (U+0964/U+0965) end sentences like '.'
+        const bool danda = c == 0xE0 && i + 2 < text.size() &&
+                           (unsigned char)text[i + 1] == 0xA5 &&
+                           ((unsigned char)text[i + 2] == 0xA4 || (unsigned char)text[i + 2] == 0xA5);
+        if (danda) { i += 2; gap = true; continue; }
+        if (c < 0x80 && c != '?' && !isalnum(c)) { gap = true; continue; }
+        if (gap && !out.empty() && c != '?') out += ' ';
+        gap = false;
+        out += c < 0x80 ? (char)tolower(c) : (char)c;
+    }
+    return out;
+}
+
+static std::string make_key(const std::string& src, const std::string& tgt, const std::string& text) {
+    return src + '\x1f' + tgt + '\x1f' + tm_normalize(text);
+}
+
+// The record at offset, if it is still the one written with seq (it may
+// have been overwritten since). Caller holds g_mu.
+static const TmRecord* live_record(uint32_t offset, uint32_t seq) {
+    if (seq == 0 || (uint64_t)offset + sizeof(TmRecord) > g_hdr->data_bytes) return nullptr;
+    const auto* r = reinterpret_cast<const TmRecord*>(g_data + offset);
+    if (r->seq != seq) return nullptr;
+    if ((uint64_t)offset + sizeof(TmRecord) + r->key_len + r->val_len > g_hdr->data_bytes) return nullptr;
+    return r;
+}
+
+static const TmRecord* live_record(const TmSlot& s) {
+    return live_record(s.offset, s.seq);
+}
+
+static bool key_matches(const TmRecord* r, const std::string& key) {
+    return r->key_len == key.size() &&
+           memcmp(reinterpret_cast<const uint8_t*>(r + 1), key.data(), key.size()) == 0;
+}
+
+// ── Fuzzy index ───────────────────────────────────────────────────────────────
+//
+//  In-memory inverted index from character trigrams of the normalized source
+//  to entries, plus each entry's sorted trigram list, rebuilt from the hash
+//  slots on open and extended on put. Entries whose record has been
+//  overwritten stay indexed until the next rebuild; they are skipped when a
+//  candidate is verified. Once they could be half the index, the put that
+//  notices rebuilds it, with only the slot scan under g_mu.
+//
+//  Lookup uses prefix filtering: an entry can only reach Dice >= t if it
+//  shares at least m = ceil(t·|A| / (2 - t)) of the query's |A| trigrams,
+//  so it must contain one of the |A| - m + 1 rarest ones. Those posting
+//  lists are scanned rarest first, counting hits per entry, until the prefix
+//  is covered or FZ_SCAN_BUDGET postings have been read; the FZ_VERIFY
+//  entries with the most hits are then scored exactly by merging trigram
+//  lists. Common trigrams (" th", "the") are never scanned, which keeps a
+//  lookup well under a millisecond at 100k entries (translation_memory_bench
+//  in app/src/test/cpp); the budget makes it approximate only for queries
+//  made entirely of common trigrams.
+
+struct FuzzyEntry {
+    uint32_t offset;
+    uint32_t seq;
+    uint32_t pair;       // hash of "src\x1ftgt\x1f"
+    uint32_t gram_off;   // into FuzzyIndex::grams
+    uint32_t n_grams;
+};
+
+struct FuzzyIndex {
+    std::vector<FuzzyEntry>                             entries;
+    std::vector<uint32_t>                               grams;      // per entry, sorted
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+};
+
+// A live record's key, copied so an index can be built without g_mu.
+struct FuzzySource {
+    uint32_t    offset;
+    uint32_t    seq;
+    std::string key;
+};
+
+static FuzzyIndex           g_fz;
+static std::vector<uint8_t> g_fz_seen;            // scratch, per entry
+static size_t               g_fz_puts    = 0;     // since last rebuild
+static uint32_t             g_fz_gen     = 0;     // bumped by open/close; stale rebuilds are dropped
+static bool                 g_fz_rebuilding = false;
+static std::vector<std::pair<uint32_t, uint32_t>> g_fz_late;   // (offset, seq) put during a rebuild
+
+static constexpr size_t FZ_SCAN_BUDGET = 8192;
+static constexpr int    FZ_MIN_GRAMS   = 4;    // scanned even past the budget
+static constexpr size_t FZ_VERIFY      = 32;
+
+static void trigrams(const std::string& norm, std::vector<uint32_t>& out) {
+    out.clear();
+    const std::string s = " " + norm + " ";
+    for (size_t i = 0; i + 3 <= s.size(); ++i) {
+        out.push_back((uint32_t)(unsigned char)s[i] |
+                      (uint32_t)(unsigned char)s[i + 1] << 8 |
+                      (uint32_t)(unsigned char)s[i + 2] << 16);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// Splits a stored key into its pair hash and normalized source.
+static uint32_t split_key(const char* key, uint32_t len, std::string& norm) {
+    const char* end = key + len;
+    const char* p   = std::find(key, end, '\x1f');
+    if (p != end) p = std::find(p + 1, end, '\x1f');
+    if (p == end) { norm.clear(); return 0; }
+    norm.assign(p + 1, end);
+    return (uint32_t)fnv1a(std::string(key, p + 1));
+}
+
+static void fz_add(FuzzyIndex& ix, uint32_t offset, uint32_t seq, const char* key, uint32_t key_len,
+                   std::vector<uint32_t>& grams) {
+    std::string norm;
+    const uint32_t pair = split_key(key, key_len, norm);
+    trigrams(norm, grams);
+    const uint32_t id = (uint32_t)ix.entries.size();
+    ix.entries.push_back({ offset, seq, pair, (uint32_t)ix.grams.size(), (uint32_t)grams.size() });
+    ix.grams.insert(ix.grams.end(), grams.begin(), grams.end());
+    for (uint32_t g : grams) ix.postings[g].push_back(id);
+}
+
+// Caller holds g_mu.
+static std::vector<FuzzySource> fz_sources() {
+    std::vector<FuzzySource> out;
+    for (uint32_t i = 0; i < g_hdr->n_slots; ++i) {
+        const TmRecord* r = live_record(g_slots[i]);
+        if (r) out.push_back({ g_slots[i].offset, g_slots[i].seq,
+                               std::string(reinterpret_cast<const char*>(r + 1), r->key_len) });
+    }
+    return out;
+}
+
+static void fz_build(const std::vector<FuzzySource>& sources, FuzzyIndex& ix) {
+    std::vector<uint32_t> grams;
+    for (const FuzzySource& src : sources) {
+        fz_add(ix, src.offset, src.seq, src.key.data(), (uint32_t)src.key.size(), grams);
+    }
+}
+
+// Replaces the index with a fresh one. Caller must not hold g_mu: only the
+// slot scan runs under it, so lookups and puts aren't held up by the
+// trigram work. Records put meanwhile are added before the swap.
+static void fz_rebuild_unlocked() {
+    std::vector<FuzzySource> sources;
+    uint32_t gen;
+    {
+        std::lock_guard<std::mutex> lk(g_mu);
+        if (!g_base || g_fz_rebuilding) return;
+        g_fz_rebuilding = true;
+        g_fz_late.clear();
+        sources = fz_sources();
+        gen = g_fz_gen;
+    }
+    FuzzyIndex ix;
+    fz_build(sources, ix);
+
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (gen != g_fz_gen) return;   // reopened or closed meanwhile
+    std::vector<uint32_t> grams;
+    for (const auto& late : g_fz_late) {
+        const TmRecord* r = live_record(late.first, late.second);
+        if (r) fz_add(ix, late.first, late.second, reinterpret_cast<const char*>(r + 1), r->key_len, grams);
+    }
+    g_fz = std::move(ix);
+    g_fz_seen.clear();
+    g_fz_late.clear();
+    g_fz_puts       = 0;
+    g_fz_rebuilding = false;
+}
+
+// The numbers in a normalized text, as ASCII digit runs (utf8_digit()).
+static std::vector<std::string> digit_runs(const std::string& norm) {
+    std::vector<std::string> runs;
+    std::string cur;
+    for (size_t i = 0; i < norm.size();) {
+        int len;
+        const int digit = utf8_digit(std::string_view(norm).substr(i), len);
+        if (digit >= 0) {
+            cur += (char)('0' + digit);
+        } else if (!cur.empty()) {
+            runs.push_back(cur);
+            cur.clear();
+        }
+        i += len;
+    }
+    if (!cur.empty()) runs.push_back(cur);
+    return runs;
+}
+
+static int shared_grams(const std::vector<uint32_t>& a, const uint32_t* b, uint32_t nb) {
+    int n = 0;
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < nb) {
+        if      (a[i] < b[j]) ++i;
+        else if (b[j] < a[i]) ++j;
+        else { ++n; ++i; ++j; }
+    }
+    return n;
+}
+
+bool tm_fuzzy_lookup(const std::string& src_lang, const std::string& tgt_lang,
+                     const std::string& text, float min_score, TmFuzzyHit& out) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (!g_base || g_fz.entries.empty()) return false;
+
+    const std::string norm = tm_normalize(text);
+    std::vector<uint32_t> grams;
+    trigrams(norm, grams);
+    if (grams.empty() || min_score <= 0.0f) return false;
+    const uint32_t pair = (uint32_t)fnv1a(src_lang + '\x1f' + tgt_lang + '\x1f');
+
+    // Bounds for Dice >= t: shared trigrams, and the entry's own trigram count
+    const float na     = (float)grams.size();
+    const float min_nb = min_score * na / (2.0f - min_score);
+    const float max_nb = na * (2.0f - min_score) / min_score;
+    const int   prefix = (int)grams.size() - (int)std::ceil(min_nb) + 1;
+
+    // Rarest first; only the prefix that any match must hit is scanned
+    std::vector<std::pair<size_t, uint32_t>> by_rarity;
+    for (uint32_t g : grams) {
+        auto it = g_fz.postings.find(g);
+        by_rarity.emplace_back(it == g_fz.postings.end() ? 0 : it->second.size(), g);
+    }
+    std::sort(by_rarity.begin(), by_rarity.end());
+
+    // Count prefix hits per entry (g_fz_seen saturates at 255)
+    g_fz_seen.resize(g_fz.entries.size(), 0);
+    std::vector<uint32_t> touched;
+    size_t scanned = 0;
+    for (int k = 0; k < prefix; ++k) {
+        if (k >= FZ_MIN_GRAMS && scanned >= FZ_SCAN_BUDGET) break;
+        auto it = g_fz.postings.find(by_rarity[k].second);
+        if (it == g_fz.postings.end()) continue;
+        scanned += it->second.size();
+        for (uint32_t id : it->second) {
+            uint8_t& c = g_fz_seen[id];
+            if (c == 0) touched.push_back(id);
+            if (c < 255) ++c;
+        }
+    }
+
+    std::vector<std::pair<int, uint32_t>> ranked;
+    for (uint32_t id : touched) {
+        const FuzzyEntry& e = g_fz.entries[id];
+        if (e.pair == pair && e.n_grams >= min_nb && e.n_grams <= max_nb) {
+            ranked.emplace_back(g_fz_seen[id], id);
+        }
+        g_fz_seen[id] = 0;
+    }
+    if (ranked.size() > FZ_VERIFY) {
+        std::partial_sort(ranked.begin(), ranked.begin() + FZ_VERIFY, ranked.end(),
+                          [](auto& a, auto& b) { return a.first > b.first; });
+        ranked.resize(FZ_VERIFY);
+    }
+
+    // Dice coefficient over the full trigram sets
+    std::vector<std::pair<float, uint32_t>> cands;
+    for (const auto& rk : ranked) {
+        const FuzzyEntry& e = g_fz.entries[rk.second];
+        const int   common = shared_grams(grams, &g_fz.grams[e.gram_off], e.n_grams);
+        const float score  = 2.0f * common / (na + (float)e.n_grams);
+        if (score >= min_score) cands.emplace_back(score, rk.second);
+    }
+    std::sort(cands.begin(), cands.end(), [](auto& a, auto& b) { return a.first > b.first; });
+
+    for (const auto& c : cands) {
+        const FuzzyEntry& e = g_fz.entries[c.second];
+        const TmRecord*   r = live_record(e.offset, e.seq);
+        if (!r) continue;
+        const char* key = reinterpret_cast<const char*>(r + 1);
+        split_key(key, r->key_len, out.source);
+        out.translation.assign(key + r->key_len, r->val_len);
+        out.score        = c.first;
+        out.same_numbers = digit_runs(norm) == digit_runs(out.source);
+        return true;
+    }
+    return false;
+}
+
+static void init_header(uint32_t data_bytes, uint32_t n_slots) {
+    memset(g_base, 0, g_map_size);
+    g_hdr->magic      = TM_MAGIC;
+    g_hdr->version    = TM_VERSION;
+    g_hdr->n_slots    = n_slots;
+    g_hdr->data_bytes = data_bytes;
+    g_hdr->next_seq   = 1;
+}
+
+bool tm_open(const char* path, uint32_t data_bytes, uint32_t n_slots) {
+    tm_close();
+    std::lock_guard<std::mutex> lk(g_mu);
+    data_bytes &= ~7u;
+    const size_t total = sizeof(TmHeader) + (size_t)n_slots * sizeof(TmSlot) + data_bytes;
+
+    g_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (g_fd < 0) { LOGE("open(%s) failed", path); return false; }
+
+    struct stat sb {};
+    fstat(g_fd, &sb);
+    const bool resize = (size_t)sb.st_size != total;
+    if (resize && ftruncate(g_fd, (off_t)total) != 0) {
+        LOGE("ftruncate(%s) failed", path);
+        close(g_fd); g_fd = -1;
+        return false;
+    }
+
+    void* p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, g_fd, 0);
+    if (p == MAP_FAILED) {
+        LOGE("mmap(%s) failed", path);
+        close(g_fd); g_fd = -1;
+        return false;
+    }
+    g_base     = static_cast<uint8_t*>(p);
+    g_map_size = total;
+    g_hdr      = reinterpret_cast<TmHeader*>(g_base);
+    g_slots    = reinterpret_cast<TmSlot*>(g_hdr + 1);
+    g_data     = reinterpret_cast<uint8_t*>(g_slots + n_slots);
+    g_stats    = {};
+
+    if (resize || g_hdr->magic != TM_MAGIC || g_hdr->version != TM_VERSION ||
+        g_hdr->n_slots != n_slots || g_hdr->data_bytes != data_bytes || g_hdr->head > data_bytes) {
+        init_header(data_bytes, n_slots);
+        LOGI("Created %s (%u slots, %u KB)", path, n_slots, data_bytes / 1024);
+    } else {
+        LOGI("Opened %s (%u KB used)", path,
+             (g_hdr->wrapped ? data_bytes : g_hdr->head) / 1024);
+    }
+    ++g_fz_gen;
+    g_fz            = FuzzyIndex();
+    g_fz_rebuilding = false;
+    fz_build(fz_sources(), g_fz);
+    LOGI("Fuzzy index: %zu entries, %zu trigrams", g_fz.entries.size(), g_fz.postings.size());
+    return true;
+}
+
+bool tm_lookup(const std::string& src_lang, const std::string& tgt_lang,
+               const std::string& text, std::string& out) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (!g_base) return false;
+    const std::string key = make_key(src_lang, tgt_lang, text);
+    const uint64_t    h   = fnv1a(key);
+    for (int i = 0; i < MAX_PROBE; ++i) {
+        const TmSlot& s = g_slots[(h + i) % g_hdr->n_slots];
+        if (s.seq == 0) break;
+        if (s.hash != h) continue;
+        const TmRecord* r = live_record(s);
+        if (r && key_matches(r, key)) {
+            out.assign(reinterpret_cast<const char*>(r + 1) + r->key_len, r->val_len);
+            ++g_stats.hits;
+            return true;
+        }
+    }
+    ++g_stats.misses;
+    return false;
+}
+
+// Returns whether the fuzzy index is due for a rebuild.
+static bool tm_put_locked(const std::string& src_lang, const std::string& tgt_lang,
+                          const std::string& text, const std::string& translation) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (!g_base || translation.empty()) return false;
+    const std::string key = make_key(src_lang, tgt_lang, text);
+    const uint64_t    h   = fnv1a(key);
+
+    const size_t need = (sizeof(TmRecord) + key.size() + translation.size() + 7) & ~(size_t)7;
+    if (need > g_hdr->data_bytes / 4) return false;   // not worth evicting a quarter of the memory
+
+    // Slot: same key, else empty or stale, else the oldest in the probe window
+    TmSlot* slot = nullptr;
+    for (int i = 0; i < MAX_PROBE && !slot; ++i) {
+        TmSlot& s = g_slots[(h + i) % g_hdr->n_slots];
+        const TmRecord* r = live_record(s);
+        if (!r || (s.hash == h && key_matches(r, key))) slot = &s;
+    }
+    if (!slot) {
+        slot = &g_slots[h % g_hdr->n_slots];
+        for (int i = 1; i < MAX_PROBE; ++i) {
+            TmSlot& s = g_slots[(h + i) % g_hdr->n_slots];
+            if (s.seq < slot->seq) slot = &s;
+        }
+    }
+
+    // Append, wrapping over the oldest records when the area is full
+    if (g_hdr->head + need > g_hdr->data_bytes) {
+        g_hdr->head    = 0;
+        g_hdr->wrapped = 1;
+    }
+    const uint32_t offset = g_hdr->head;
+    const uint32_t seq    = g_hdr->next_seq++;
+    if (g_hdr->next_seq == 0) g_hdr->next_seq = 1;
+
+    auto* r = reinterpret_cast<TmRecord*>(g_data + offset);
+    r->seq      = seq;
+    r->key_len  = (uint32_t)key.size();
+    r->val_len  = (uint32_t)translation.size();
+    r->reserved = 0;
+    memcpy(r + 1, key.data(), key.size());
+    memcpy(reinterpret_cast<uint8_t*>(r + 1) + key.size(), translation.data(), translation.size());
+    g_hdr->head += (uint32_t)need;
+
+    slot->hash   = h;
+    slot->offset = offset;
+    slot->seq    = seq;
+    ++g_stats.puts;
+
+    std::vector<uint32_t> grams;
+    fz_add(g_fz, offset, seq, reinterpret_cast<const char*>(r + 1), r->key_len, grams);
+    if (g_fz_rebuilding) g_fz_late.emplace_back(offset, seq);
+
+    // Once wrapping, overwritten entries pile up in the postings: rebuild
+    // when they could be half the index
+    return g_hdr->wrapped && ++g_fz_puts > g_fz.entries.size() / 2 && !g_fz_rebuilding;
+}
+
+void tm_put(const std::string& src_lang, const std::string& tgt_lang,
+            const std::string& text, const std::string& translation) {
+    if (tm_put_locked(src_lang, tgt_lang, text, translation)) fz_rebuild_unlocked();
+}
+
+void tm_close() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    // MAP_SHARED pages live in the page cache, so puts survive a process
+    // kill even without this; msync covers power loss on a clean shutdown.
+    if (g_base) {
+        msync(g_base, g_map_size, MS_SYNC);
+        munmap(g_base, g_map_size);
+    }
+    if (g_fd >= 0) close(g_fd);
+    g_fd = -1; g_base = nullptr; g_map_size = 0;
+    g_hdr = nullptr; g_slots = nullptr; g_data = nullptr;
+    g_fz = FuzzyIndex();
+    g_fz_seen.clear();
+    g_fz_late.clear();
+    ++g_fz_gen;
+    g_fz_rebuilding = false;
+}
+
+TmStats tm_stats() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    TmStats st = g_stats;
+    st.bytes_used = g_hdr ? (g_hdr->wrapped ? g_hdr->data_bytes : g_hdr->head) : 0;
+    return st;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Persistent exact-match translation memory.
+//
+// Keys are (source language, target language, normalized transcript):
+// lowercased, punctuation other than '?' dropped, whitespace collapsed, so
+// Whisper's "Where is the bathroom?" and "where is the bathroom ?" agree.
+//
+// Storage is one memory-mapped file of fixed size: a header, an
+// open-addressed hash index and a circular, append-only record area. When
+// the record area wraps, the oldest records are overwritten; index slots
+// still pointing at them fail the sequence check and read as misses, so
+// the file never grows and never needs compaction.
+//
+// Fuzzy lookup scores entries of the same language pair by the Dice
+// coefficient of their character trigram sets, through an in-memory
+// inverted index, so near-repeats (one word or punctuation apart) match.
+// A near-repeat that changes a number scores high all the same, so a hit
+// says whether the digit sequences agree; only then is its translation
+// safe to reuse as is.
+
+struct TmStats {
+    int64_t hits;
+    int64_t misses;
+    int64_t puts;
+    int64_t bytes_used;    // record area written so far (caps at capacity)
+};
+
+struct TmFuzzyHit {
+    std::string source;        // normalized source of the matched entry
+    std::string translation;
+    float       score;         // 0..1, 1 = same trigram set
+    bool        same_numbers;  // both have the same digit sequences
+};
+
+bool        tm_open(const char* path, uint32_t data_bytes, uint32_t n_slots);
+// On a hit, copies the stored translation to out.
+bool        tm_lookup(const std::string& src_lang, const std::string& tgt_lang,
+                      const std::string& text, std::string& out);
+// Best entry scoring at least min_score.
+bool        tm_fuzzy_lookup(const std::string& src_lang, const std::string& tgt_lang,
+                            const std::string& text, float min_score, TmFuzzyHit& out);
+void        tm_put(const std::string& src_lang, const std::string& tgt_lang,
+                   const std::string& text, const std::string& translation);
+void        tm_close();
+TmStats     tm_stats();
+std::string tm_normalize(const std::string& text);
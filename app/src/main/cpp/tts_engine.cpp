@@ -0,0 +1,169 @@
+#include "tts_engine.h"
+#include "audio_cache.h"
+#include "ort_cache.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+
+#define TAG  "TtsEngine"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#ifdef TRANSLATOR_SHERPA_C_API
+#include "sherpa-onnx/c-api/c-api.h"
+#include <cstring>
+
+struct Voice {
+    std::string                 name;
+    TtsVoiceConfig              cfg;
+    const SherpaOnnxOfflineTts* tts;
+    std::mutex                  mu;   // one synthesis at a time per model
+
+    ~Voice() { SherpaOnnxDestroyOfflineTts(tts); }
+};
+
+static std::mutex g_mu;
+// Most recently used first. A voice being synthesized with stays alive
+// through its shared_ptr even if it is unloaded meanwhile.
+static std::list<std::shared_ptr<Voice>> g_voices;
+
+bool tts_engine_available() { return true; }
+
+bool tts_engine_load(const std::string& voice, const TtsVoiceConfig& cfg, int max_voices) {
+    {
+        std::lock_guard<std::mutex> lock(g_mu);
+        for (auto it = g_voices.begin(); it != g_voices.end(); ++it) {
+            if ((*it)->name == voice) {
+                g_voices.splice(g_voices.begin(), g_voices, it);
+                return true;
+            }
+        }
+    }
+
+    // The graph-optimized copy when there is one; see ort_cache.h
+    const std::string model = ort_cache_model(cfg.model);
+    SherpaOnnxOfflineTtsConfig config;
+    memset(&config, 0, sizeof(config));
+    config.model.vits.model         = model.c_str();
+    config.model.vits.tokens        = cfg.tokens.c_str();
+    config.model.vits.lexicon       = cfg.lexicon.c_str();
+    config.model.vits.length_scale  = cfg.length_scale;
+    config.model.vits.noise_scale   = cfg.noise_scale;
+    config.model.vits.noise_scale_w = cfg.noise_scale_w;
+    config.model.num_threads        = cfg.n_threads;
+    config.model.provider           = "cpu";
+    config.max_num_sentences        = 1;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const SherpaOnnxOfflineTts* tts = SherpaOnnxCreateOfflineTts(&config);
+    if (!tts && model != cfg.model) {
+        LOGE("Optimized copy of %s failed to load; using the original", cfg.model.c_str());
+        ort_cache_drop(cfg.model);
+        config.model.vits.model = cfg.model.c_str();
+        tts = SherpaOnnxCreateOfflineTts(&config);
+    }
+    if (!tts) { LOGE("Failed to load voice %s: %s", voice.c_str(), cfg.model.c_str()); return false; }
+    auto v = std::make_shared<Voice>();
+    v->name = voice;
+    v->cfg  = cfg;
+    v->tts  = tts;
+    LOGI("Voice %s loaded in %.0f ms (%d Hz)", voice.c_str(),
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(),
+         SherpaOnnxOfflineTtsSampleRate(tts));
+
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_voices.push_front(std::move(v));
+    while ((int)g_voices.size() > std::max(max_voices, 1)) {
+        LOGI("Unloading voice %s", g_voices.back()->name.c_str());
+        g_voices.pop_back();
+    }
+    return true;
+}
+
+// The loaded voice, marked most recently used; null if not loaded.
+static std::shared_ptr<Voice> find_voice(const std::string& voice) {
+    std::lock_guard<std::mutex> lock(g_mu);
+    for (auto it = g_voices.begin(); it != g_voices.end(); ++it) {
+        if ((*it)->name == voice) {
+            g_voices.splice(g_voices.begin(), g_voices, it);
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+struct StreamState {
+    const std::function<bool(TtsClip*)>* on_chunk;
+    int                sample_rate;
+    int                n_samples;   // delivered so far
+    bool               stopped;
+};
+
+static int32_t on_generated(const float* samples, int32_t n, void* arg) {
+    auto* st = static_cast<StreamState*>(arg);
+    if (n <= 0) return 1;
+    st->n_samples += n;
+    auto* clip = new TtsClip { std::vector<float>(samples, samples + n), st->sample_rate, false };
+    if ((*st->on_chunk)(clip)) return 1;
+    st->stopped = true;
+    return 0;
+}
+
+int tts_engine_synthesize_stream(const std::string& voice, const std::string& text, float speed,
+                                 const std::function<bool(TtsClip*)>& on_chunk) {
+    std::shared_ptr<Voice> v = find_voice(voice);
+    if (!v) return -1;
+
+    const uint64_t key = ac_key(text, voice, v->cfg.length_scale, v->cfg.noise_scale,
+                                v->cfg.noise_scale_w, speed);
+    auto clip = std::make_unique<TtsClip>();
+    if (ac_lookup(key, clip->pcm)) {
+        clip->sample_rate = SherpaOnnxOfflineTtsSampleRate(v->tts);
+        clip->cached      = true;
+        const int n = (int)clip->pcm.size();
+        on_chunk(clip.release());
+        return n;
+    }
+
+    StreamState st { &on_chunk, SherpaOnnxOfflineTtsSampleRate(v->tts), 0, false };
+    const SherpaOnnxGeneratedAudio* audio;
+    {
+        std::lock_guard<std::mutex> lock(v->mu);
+        audio = SherpaOnnxOfflineTtsGenerateWithCallbackWithArg(v->tts, text.c_str(), 0, speed,
+                                                                on_generated, &st);
+    }
+    // The returned audio is the whole segment again: cached as is, so the
+    // chunks need no copy of their own
+    if (audio) {
+        if (!st.stopped && audio->n > 0) ac_put(key, audio->samples, audio->n);
+        SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
+    }
+    return st.n_samples;
+}
+
+void tts_engine_release() {
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_voices.clear();
+}
+
+#else   // no C API library: the Kotlin OfflineTts path is used
+
+bool tts_engine_available() { return false; }
+
+bool tts_engine_load(const std::string&, const TtsVoiceConfig&, int) { return false; }
+
+int tts_engine_synthesize_stream(const std::string&, const std::string&, float,
+                                 const std::function<bool(TtsClip*)>&) {
+    return -1;
+}
+
+void tts_engine_release() {}
+
+#endif
+
+void tts_clip_free(TtsClip* clip) {
+    delete clip;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// MMS VITS synthesis inside translator_native, through the sherpa-onnx C API.
+//
+// The text crosses JNI once, and the PCM stays in native memory: the audio
+// cache is consulted and filled here, and the clip is handed to AudioTrack
+// as a direct ByteBuffer over TtsClip::pcm, so no sample array is created
+// on the JVM heap or copied across JNI.
+//
+// Built only when libsherpa-onnx-c-api.so and its header are present (see
+// CMakeLists.txt); otherwise tts_engine_available() is false and the Kotlin
+// OfflineTts path is used.
+
+struct TtsVoiceConfig {
+    std::string model;
+    std::string tokens;
+    std::string lexicon;   // may be empty
+    float       length_scale;
+    float       noise_scale;
+    float       noise_scale_w;
+    int         n_threads;
+};
+
+struct TtsClip {
+    std::vector<float> pcm;
+    int                sample_rate;
+    bool               cached;   // came from the audio cache
+};
+
+bool tts_engine_available();
+
+// Loads voice (an MMS code) unless already loaded, keeping at most
+// max_voices; the least recently used is unloaded first.
+bool tts_engine_load(const std::string& voice, const TtsVoiceConfig& cfg, int max_voices);
+
+// Audio for text in voice, from the cache or synthesized (and cached). Each
+// chunk (a sentence of text, as the model splits it) is passed to on_chunk
+// as soon as it is decoded; the callee owns it and frees it with
+// tts_clip_free(). Returning false stops synthesis. A cached segment arrives
+// as one chunk. Returns the total samples, or -1 if the voice is not loaded.
+int tts_engine_synthesize_stream(const std::string& voice, const std::string& text, float speed,
+                                 const std::function<bool(TtsClip*)>& on_chunk);
+
+void tts_clip_free(TtsClip* clip);
+
+void tts_engine_release();
@@ -0,0 +1,61 @@
+#include "utf8.h"
+
+static int utf8_len(unsigned char lead) {
+    if (lead < 0x80)           return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+    return 0;   // continuation byte or invalid
+}
+
+size_t utf8_complete_prefix(std::string_view s) {
+    // The last lead byte decides whether the tail is a whole character
+    size_t i = s.size();
+    while (i > 0 && ((unsigned char)s[i - 1] & 0xC0) == 0x80 && s.size() - i < 3) --i;
+    if (i == 0) return 0;
+    const int need = utf8_len((unsigned char)s[i - 1]);
+    return need > 0 && (i - 1) + need <= s.size() ? s.size() : i - 1;
+}
+
+uint32_t utf8_decode(std::string_view s, int& n) {
+    n = s.empty() ? 0 : utf8_len((unsigned char)s[0]);
+    if (n == 0 || (size_t)n > s.size()) { n = 1; return 0; }
+    static const unsigned char LEAD_MASK[] = { 0, 0x7F, 0x1F, 0x0F, 0x07 };
+    uint32_t cp = (unsigned char)s[0] & LEAD_MASK[n];
+    for (int i = 1; i < n; ++i) cp = (cp << 6) | ((unsigned char)s[i] & 0x3F);
+    return cp;
+}
+
+bool utf8_is_unspaced(uint32_t cp) {
+    return (cp >= 0x0E00 && cp <= 0x0EFF) || (cp >= 0x1000 && cp <= 0x109F) ||
+           (cp >= 0x1780 && cp <= 0x17FF) || (cp >= 0x3040 && cp <= 0x30FF) ||
+           (cp >= 0x3400 && cp <= 0x4DBF) || (cp >= 0x4E00 && cp <= 0x9FFF) ||
+           (cp >= 0xF900 && cp <= 0xFAFF);
+}
+
+int utf8_digit(std::string_view s, int& n) {
+    const uint32_t cp = utf8_decode(s, n);
+    if (cp >= '0' && cp <= '9') return (int)(cp - '0');
+    if (cp >= 0x0660 && cp <= 0x0669) return (int)(cp - 0x0660);
+    if (cp >= 0x06F0 && cp <= 0x06F9) return (int)(cp - 0x06F0);
+    if (cp >= 0x0900 && cp <= 0x0DFF && (cp & 0x7F) >= 0x66 && (cp & 0x7F) <= 0x6F) {
+        return (int)((cp & 0x7F) - 0x66);
+    }
+    if (cp >= 0x0E50 && cp <= 0x0E59) return (int)(cp - 0x0E50);
+    return -1;
+}
+
+int utf8_count_words(std::string_view s) {
+    int words = 0;
+    bool in_word = false;
+    for (size_t i = 0; i < s.size();) {
+        int n;
+        const uint32_t cp = utf8_decode(s.substr(i), n);
+        i += n;
+        if (cp == ' ' || cp == '\t' || cp == '\n') { in_word = false; continue; }
+        if (utf8_is_unspaced(cp)) { ++words; in_word = false; continue; }
+        if (!in_word) ++words;
+        in_word = true;
+    }
+    return words;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// UTF-8 helpers shared by the token tables, the translation memory and the
+// entity masker. No llama.cpp dependency, so they build for host tests too.
+
+// Length of the longest prefix of s that ends on a character boundary.
+size_t utf8_complete_prefix(std::string_view s);
+
+// Code point at the start of s (0 if s doesn't start with a whole character);
+// n gets its length in bytes, at least 1.
+uint32_t utf8_decode(std::string_view s, int& n);
+
+// Thai, Lao, Myanmar, Khmer, kana and CJK ideographs: no spaces between words.
+bool utf8_is_unspaced(uint32_t cp);
+
+// Value of the decimal digit at the start of s, or -1: ASCII, Arabic-Indic,
+// Devanagari and the other Indic scripts (U+0966..U+0DEF, digits at
+// xx66..xx6F) and Thai. n gets the character's length in bytes.
+int utf8_digit(std::string_view s, int& n);
+
+// Words in s: whitespace-separated runs, except that every character of a
+// script written without spaces counts as a word of its own. Matches
+// simulWords() in PipelineManager.kt.
+int utf8_count_words(std::string_view s);
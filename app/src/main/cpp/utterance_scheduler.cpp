@@ -0,0 +1,171 @@
+#include "utterance_scheduler.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#define TAG  "UtteranceScheduler"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+
+static constexpr int SAMPLE_RATE     = 16000;
+static constexpr int MERGE_SILENCE_N = SAMPLE_RATE / 10;   // 100 ms between merged fragments
+
+using Clock = std::chrono::steady_clock;
+
+struct Job {
+    std::vector<float> pcm;
+    int                priority;
+    uint64_t           seq;
+    Clock::time_point  arrival;    // first fragment
+    Clock::time_point  last_in;    // most recent fragment merged in
+    Clock::time_point  deadline;
+};
+
+static std::mutex              g_mu;
+static std::condition_variable g_cv;
+static std::deque<Job>         g_queue;    // kept sorted: priority desc, seq asc
+static SchedConfig             g_cfg;
+static SchedStats              g_stats   = {};
+static uint64_t                g_seq     = 0;
+static bool                    g_closed  = false;
+
+static Clock::time_point deadline_for(const Job& j) {
+    const int64_t audio_ms = (int64_t)j.pcm.size() * 1000 / SAMPLE_RATE;
+    return j.arrival + std::chrono::milliseconds(
+            g_cfg.max_wait_ms + audio_ms * g_cfg.wait_per_audio_s / 1000);
+}
+
+static void insert_sorted(Job&& j) {
+    auto it = std::find_if(g_queue.begin(), g_queue.end(), [&](const Job& q) {
+        return q.priority < j.priority;
+    });
+    g_queue.insert(it, std::move(j));
+}
+
+// Drops every job whose deadline has already passed. Caller holds g_mu.
+static void shed_expired(Clock::time_point now) {
+    for (auto it = g_queue.begin(); it != g_queue.end();) {
+        if (now > it->deadline) {
+            LOGW("Shed utterance #%llu: deadline passed (%zu samples)",
+                 (unsigned long long)it->seq, it->pcm.size());
+            ++g_stats.shed_expired;
+            it = g_queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    g_stats.queue_depth = (int64_t)g_queue.size();
+}
+
+void sched_configure(const SchedConfig& cfg) {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_cfg = cfg;
+    g_cfg.capacity = std::max(g_cfg.capacity, 1);
+    LOGI("Config: capacity=%d wait=%d ms (+%d ms/s of audio), merge <%d samples within %d ms",
+         g_cfg.capacity, g_cfg.max_wait_ms, g_cfg.wait_per_audio_s,
+         g_cfg.merge_max_samples, g_cfg.merge_gap_ms);
+}
+
+void sched_submit(const float* pcm, int n_samples, int priority) {
+    if (!pcm || n_samples <= 0) return;
+    const auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lk(g_mu);
+    if (g_closed) return;
+    ++g_stats.submitted;
+    shed_expired(now);
+
+    // Merge into the most recent queued fragment if both are short and close
+    // together; Whisper handles one 2 s clip far better than two 1 s ones.
+    if (!g_queue.empty() && n_samples < g_cfg.merge_max_samples) {
+        auto tail = std::max_element(g_queue.begin(), g_queue.end(),
+                                     [](const Job& a, const Job& b) { return a.seq < b.seq; });
+        const auto gap = std::chrono::duration_cast<std::chrono::milliseconds>(now - tail->last_in);
+        if ((int)tail->pcm.size() < g_cfg.merge_max_samples
+                && gap.count() <= g_cfg.merge_gap_ms
+                && tail->priority == priority) {
+            tail->pcm.insert(tail->pcm.end(), MERGE_SILENCE_N, 0.0f);
+            tail->pcm.insert(tail->pcm.end(), pcm, pcm + n_samples);
+            tail->last_in  = now;
+            tail->deadline = deadline_for(*tail);
+            ++g_stats.merged;
+            LOGI("Merged fragment into #%llu (%zu samples)",
+                 (unsigned long long)tail->seq, tail->pcm.size());
+            return;
+        }
+    }
+
+    if ((int)g_queue.size() >= g_cfg.capacity) {
+        // Lowest priority sits at the back; among equals, shed the oldest.
+        const int lowest = g_queue.back().priority;
+        auto victim = std::find_if(g_queue.begin(), g_queue.end(),
+                                   [&](const Job& q) { return q.priority == lowest; });
+        if (victim->priority > priority) {
+            LOGW("Shed incoming utterance: queue full of higher-priority work");
+            ++g_stats.shed_overflow;
+            return;
+        }
+        LOGW("Shed utterance #%llu: queue full", (unsigned long long)victim->seq);
+        g_queue.erase(victim);
+        g_stats.queue_depth = (int64_t)g_queue.size();
+        ++g_stats.shed_overflow;
+    }
+
+    Job j;
+    j.pcm.assign(pcm, pcm + n_samples);
+    j.priority = priority;
+    j.seq      = g_seq++;
+    j.arrival  = now;
+    j.last_in  = now;
+    j.deadline = deadline_for(j);
+    insert_sorted(std::move(j));
+    g_stats.queue_depth = (int64_t)g_queue.size();
+    g_cv.notify_one();
+}
+
+bool sched_next(std::vector<float>& out) {
+    std::unique_lock<std::mutex> lk(g_mu);
+    for (;;) {
+        g_cv.wait(lk, [] { return g_closed || !g_queue.empty(); });
+        if (g_closed) return false;
+
+        const auto now = Clock::now();
+        shed_expired(now);
+        if (g_queue.empty()) continue;
+
+        Job j = std::move(g_queue.front());
+        g_queue.pop_front();
+        g_stats.queue_depth = (int64_t)g_queue.size();
+        ++g_stats.started;
+
+        const int64_t waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - j.arrival).count();
+        g_stats.max_wait_ms = std::max(g_stats.max_wait_ms, waited);
+
+        out = std::move(j.pcm);
+        return true;
+    }
+}
+
+void sched_close() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_closed = true;
+    g_queue.clear();
+    g_stats.queue_depth = 0;
+    g_cv.notify_all();
+}
+
+void sched_reset() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    g_queue.clear();
+    g_stats  = {};
+    g_closed = false;
+}
+
+SchedStats sched_stats() {
+    std::lock_guard<std::mutex> lk(g_mu);
+    return g_stats;
+}
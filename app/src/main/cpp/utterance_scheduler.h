@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Bounded, deadline-aware queue of utterances waiting for Whisper.
+//
+// Jobs are served highest priority first, then in arrival order. A job that
+// has not started by its deadline is shed; when the queue is full the
+// oldest lowest-priority job is shed to make room. A short fragment that
+// arrives right after another still-queued fragment is merged into it.
+
+struct SchedConfig {
+    int capacity          = 4;       // max queued jobs
+    int max_wait_ms       = 10000;   // base deadline after arrival
+    int wait_per_audio_s  = 1000;    // extra deadline per second of audio
+    int merge_max_samples = 16000;   // fragments shorter than this (1 s) merge
+    int merge_gap_ms      = 1500;    // ... if they arrive within this gap
+};
+
+struct SchedStats {
+    int64_t submitted;
+    int64_t started;
+    int64_t merged;
+    int64_t shed_expired;
+    int64_t shed_overflow;
+    int64_t queue_depth;
+    int64_t max_wait_ms;   // longest queue wait of any started job
+};
+
+void       sched_configure(const SchedConfig& cfg);
+void       sched_submit(const float* pcm, int n_samples, int priority);
+// Blocks until a job is ready or the scheduler is closed (returns false).
+bool       sched_next(std::vector<float>& out);
+void       sched_close();
+void       sched_reset();
+SchedStats sched_stats();
@@ -0,0 +1,61 @@
+#include "vocab_table.h"
+#include <android/log.h>
+#include <chrono>
+#include <cstring>
+
+#define TAG  "VocabTable"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+
+static bool ends_with(std::string_view s, const char* suffix) {
+    const size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static uint8_t piece_flags(std::string_view p) {
+    if (p.empty()) return PIECE_EMPTY;
+    uint8_t f = 0;
+    int n;
+    if (p[0] == ' ' || p[0] == '\t' || p[0] == '\n' || utf8_is_unspaced(utf8_decode(p, n))) {
+        f |= PIECE_WORD_START;
+    }
+    if (((unsigned char)p[0] & 0xC0) == 0x80 || utf8_complete_prefix(p) != p.size()) {
+        f |= PIECE_INCOMPLETE;
+    }
+    if (p.find('\n') != std::string_view::npos) f |= PIECE_SENTENCE_END;
+
+    std::string_view t = p;
+    while (!t.empty() && (t.back() == ' ' || t.back() == '\t')) t.remove_suffix(1);
+    if (t.empty()) return f;
+
+    static const char* const SENTENCE[] = { ".", "!", "?", "।", "॥",
+                                            "。", "！", "？" };
+    static const char* const CLAUSE[]   = { ",", ";", ":", "،", "、", "，" };
+    for (const char* s : SENTENCE) if (ends_with(t, s)) f |= PIECE_SENTENCE_END;
+    for (const char* s : CLAUSE)   if (ends_with(t, s)) f |= PIECE_CLAUSE_END;
+    return f;
+}
+
+void vocab_table_build(const llama_vocab* vocab, VocabTable& out) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const int n = llama_vocab_n_tokens(vocab);
+    out.bytes.clear();
+    out.bytes.reserve((size_t)n * 8);
+    out.offsets.assign(1, 0);
+    out.offsets.reserve((size_t)n + 1);
+    out.flags.resize(n);
+
+    char buf[256];
+    for (llama_token tok = 0; tok < n; ++tok) {
+        int len = llama_token_to_piece(vocab, tok, buf, sizeof(buf), 0, true);
+        if (len < 0) len = 0;   // longer than any real piece; treated as empty
+        out.bytes.insert(out.bytes.end(), buf, buf + len);
+        out.offsets.push_back((uint32_t)out.bytes.size());
+        out.flags[tok] = piece_flags({ buf, (size_t)len });
+    }
+    out.bytes.shrink_to_fit();
+
+    LOGI("Piece table: %d tokens, %zu KB, built in %.1f ms", n,
+         (out.bytes.size() + out.offsets.size() * 4 + out.flags.size()) / 1024,
+         std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - t0).count());
+}
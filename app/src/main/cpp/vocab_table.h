@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "llama.cpp/include/llama.h"
+#include "utf8.h"
+
+// The UTF-8 piece of every token in a vocabulary, computed once per model.
+//
+// All pieces sit back to back in one buffer, so looking one up during
+// decoding is two loads instead of a llama_token_to_piece call and a string
+// copy. Each token also carries flags about its text, so word, clause and
+// sentence boundaries can be decided from the token id alone.
+
+enum PieceFlag : uint8_t {
+    PIECE_WORD_START   = 1 << 0,   // begins with whitespace, or a character of a
+                                   // script written without spaces (CJK, Thai, ...)
+    PIECE_SENTENCE_END = 1 << 1,   // ends with . ! ? । ॥ 。 ！ ？ or contains a newline
+    PIECE_CLAUSE_END   = 1 << 2,   // ends with , ; : ، 、 ，
+    PIECE_INCOMPLETE   = 1 << 3,   // not whole UTF-8 characters (byte-fallback tokens)
+    PIECE_EMPTY        = 1 << 4,   // renders as nothing (control tokens)
+};
+
+struct VocabTable {
+    std::vector<char>     bytes;
+    std::vector<uint32_t> offsets;   // n_tokens + 1
+    std::vector<uint8_t>  flags;
+
+    int size() const { return (int)flags.size(); }
+
+    std::string_view piece(llama_token tok) const {
+        return { bytes.data() + offsets[tok], offsets[tok + 1] - offsets[tok] };
+    }
+    uint8_t flag(llama_token tok) const { return flags[tok]; }
+};
+
+void vocab_table_build(const llama_vocab* vocab, VocabTable& out);
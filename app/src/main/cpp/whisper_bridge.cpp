@@ -1,7 +1,15 @@
 #include "whisper_bridge.h"
+#include "pipeline_stages.h"
+#include "thread_budget.h"
+#include "thermal_monitor.h"
+#include "model_tiers.h"
+#include "utterance_scheduler.h"
 #include "whisper.h"
 #include <android/log.h>
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <vector>
 #include "ggml.h"
 
 
@@ -9,20 +17,31 @@
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
-static whisper_context* g_ctx     = nullptr;
-static int              g_threads = 4;
+static std::vector<whisper_context*> g_tiers;          // best quality first
+static whisper_context*              g_ctx = nullptr;  // active tier
 
-bool whisper_bridge_init(const char* model_path, int n_threads) {
-    if (g_ctx) { whisper_free(g_ctx); g_ctx = nullptr; }
-    g_threads = n_threads;
+static const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
 
+bool whisper_bridge_add_tier(const char* model_path) {
     whisper_context_params cp = whisper_context_default_params();
     cp.use_gpu = false;
 
-    g_ctx = whisper_init_from_file_with_params(model_path, cp);
-    if (!g_ctx) { LOGE("Failed to load: %s", model_path); return false; }
+    whisper_context* ctx = whisper_init_from_file_with_params(model_path, cp);
+    if (!ctx) { LOGE("Failed to load: %s", model_path); return false; }
+    g_tiers.push_back(ctx);
+    tier_add(STAGE_WHISPER, base_name(model_path), model_path);
+    if (!g_ctx) g_ctx = ctx;
     LOGI("Whisper model loaded OK from %s", model_path);
     return true;
+}
+
+bool whisper_bridge_init(const char* model_path, int n_threads) {
+    whisper_bridge_free();
+    budget_set_max(STAGE_WHISPER, n_threads);
+    return whisper_bridge_add_tier(model_path);
     // After whisper_init_from_file():
     LOGI("ggml CPU features: %s", ggml_cpu_has_sme() ? "SME=ON" : "SME=OFF");
     LOGI("ggml SVE: %s", ggml_cpu_has_sve() ? "SVE=ON" : "SVE=OFF");
@@ -30,7 +49,13 @@ bool whisper_bridge_init(const char* model_path, int n_threads) {
 }
 
 std::string whisper_bridge_transcribe(const float* pcm, int n_samples, const char* lang) {
-    if (!g_ctx) return "";
+    if (g_tiers.empty()) return "";
+    thermal_tick();
+    StageScope stage(STAGE_WHISPER);
+
+    const double audio_s = n_samples / 16000.0;
+    const int    tier    = tier_select(STAGE_WHISPER, audio_s, (int)sched_stats().queue_depth);
+    g_ctx = g_tiers[tier];
 
     whisper_full_params wp    = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
     wp.language               = lang;
@@ -42,12 +67,17 @@ std::string whisper_bridge_transcribe(const float* pcm, int n_samples, const cha
     wp.print_timestamps       = false;
     wp.suppress_blank         = true;
     // ✅ REMOVED: suppress_non_speech_tokens — not in this whisper.cpp version
-    wp.n_threads              = g_threads;
+    wp.n_threads              = stage.n_threads();
     wp.audio_ctx              = 0;
 
+    const auto t0 = std::chrono::steady_clock::now();
     if (whisper_full(g_ctx, wp, pcm, n_samples) != 0) {
         LOGE("whisper_full() failed"); return "";
     }
+    const double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+    thermal_report(STAGE_WHISPER, stage.n_threads(), audio_s, ms);
+    tier_report(STAGE_WHISPER, tier, audio_s, ms);
 
     std::string out;
     int n = whisper_full_n_segments(g_ctx);
@@ -60,5 +90,8 @@ std::string whisper_bridge_transcribe(const float* pcm, int n_samples, const cha
 }
 
 void whisper_bridge_free() {
-    if (g_ctx) { whisper_free(g_ctx); g_ctx = nullptr; }
+    for (whisper_context* ctx : g_tiers) whisper_free(ctx);
+    g_tiers.clear();
+    g_ctx = nullptr;
+    tier_clear(STAGE_WHISPER);
 }
@@ -2,5 +2,7 @@
 #include <string>
 
 bool        whisper_bridge_init(const char* model_path, int n_threads);
+// Extra, faster tiers, added in order of decreasing quality after init.
+bool        whisper_bridge_add_tier(const char* model_path);
 std::string whisper_bridge_transcribe(const float* pcm, int n_samples, const char* lang);
 void        whisper_bridge_free();
@@ -28,6 +28,9 @@ class MainActivity : AppCompatActivity() {
         private const val MODEL_DIR     = "models"
         private const val WHISPER_MODEL = "ggml-tiny-q8_0.bin"
         private const val LLAMA_MODEL   = "gemma-2-2b-it-Q4_K_M.gguf"
+        // Optional faster tiers, used only if present in MODEL_DIR
+        private val WHISPER_TIERS = listOf("ggml-tiny-q5_1.bin")
+        private val LLAMA_TIERS   = listOf("gemma-2-2b-it-Q3_K_S.gguf", "gemma-2-2b-it-Q2_K.gguf")
     }
 
     private lateinit var tvStatus:           TextView
@@ -92,6 +95,9 @@ class MainActivity : AppCompatActivity() {
                 tvTranslation.text = ""
             }
         }
+        pipeline.onPartialTranscription = { text ->
+            runOnUiThread { tvTranscription.text = text }
+        }
         pipeline.onTranslationToken = { token ->
             translationBuf.append(token)
             runOnUiThread { tvTranslation.text = translationBuf.toString() }
@@ -125,6 +131,7 @@ class MainActivity : AppCompatActivity() {
         spinnerSource.onItemSelectedListener = object : AdapterView.OnItemSelectedListener {
             override fun onItemSelected(p0: AdapterView<*>?, p1: View?, pos: Int, id: Long) {
                 pipeline.sourceLanguageCode = languageMap[langNames[pos]] ?: "hi"
+                pipeline.prewarmPrompt()
             }
             override fun onNothingSelected(p0: AdapterView<*>?) {}
         }
@@ -133,6 +140,7 @@ class MainActivity : AppCompatActivity() {
             override fun onItemSelected(p0: AdapterView<*>?, p1: View?, pos: Int, id: Long) {
                 val targetCode = languageMap[langNames[pos]] ?: "en"
                 pipeline.targetLanguageCode = targetCode
+                pipeline.prewarmPrompt()
             }
             override fun onNothingSelected(p0: AdapterView<*>?) {}
         }
@@ -194,7 +202,11 @@ class MainActivity : AppCompatActivity() {
         ensureModelsPresent {
             lifecycleScope.launch(Dispatchers.IO) {
                 val modelDir = "${getExternalFilesDir(null)?.absolutePath}/mms_tts"
-                val ok = pipeline.init(whisperPath, llamaPath, modelDir)
+                val ok = pipeline.init(
+                    whisperPath, llamaPath, modelDir,
+                    whisperTiers = WHISPER_TIERS.mapNotNull { dir?.resolve(it)?.absolutePath },
+                    llamaTiers   = LLAMA_TIERS.mapNotNull { dir?.resolve(it)?.absolutePath },
+                )
                 withContext(Dispatchers.Main) {
                     tvStatus.text       = if (ok) "Ready" else "Load failed"
                     btnRecord.isEnabled = ok
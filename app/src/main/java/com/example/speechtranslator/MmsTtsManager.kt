@@ -7,14 +7,23 @@ import com.k2fsa.sherpa.onnx.OfflineTtsConfig
 import com.k2fsa.sherpa.onnx.OfflineTtsModelConfig
 import com.k2fsa.sherpa.onnx.OfflineTtsVitsModelConfig
 import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 
 class MmsTtsManager(
     private val context: Context,
-    private val modelDir: String
+    private val modelDir: String,
+    private val numThreads: Int = 4,
+    /** Spill directory for the synthesized-audio cache; null keeps it in memory. */
+    audioCacheDir: File? = null,
+    /** Directory for graph-optimized copies of the voices; null loads them as shipped. */
+    ortCacheDir: File? = null
 ) {
     companion object {
         private const val TAG = "MmsTtsManager"
         private const val MAX_CACHED_MODELS = 2
+        /** Output rate of the MMS VITS voices; each model reports its own. */
+        const val MMS_SAMPLE_RATE = 22_050
 
         /**
          * Length scale per language — controls speaking rate.
@@ -45,61 +54,171 @@ class MmsTtsManager(
         // 0.333 = smoother / more monotone, 0.667 (default) = more natural variation.
         private const val NOISE_SCALE   = 0.667f
         private const val NOISE_SCALE_W = 0.8f
+
+        // ── Audio cache ────────────────────────────────────────────────────
+        // Synthesized segments are kept as int16 PCM (audio_cache.cpp), keyed
+        // by text, voice and the synthesis parameters above. 8 MB ≈ 3 min of
+        // audio in memory; the spill directory keeps stock phrases across runs.
+        private const val AUDIO_CACHE_MEM_BYTES  = 8 * 1024 * 1024
+        private const val AUDIO_CACHE_DISK_BYTES = 32L * 1024 * 1024
+
+        // ── ONNX Runtime ───────────────────────────────────────────────────
+        // Graph optimization level baked into the cached copy of each voice
+        // (ort_cache.cpp): 0 none, 1 basic, 2 extended, 99 all. The copy is
+        // only valid on this device and ORT build, hence a cache, not an asset.
+        private const val ORT_OPT_LEVEL = 99
     }
 
+    private external fun nativeAudioCacheConfigure(memBytes: Int, spillDir: String, diskBytes: Long)
+    private external fun nativeAudioCacheKey(
+        text: String, voice: String,
+        lengthScale: Float, noiseScale: Float, noiseScaleW: Float, speed: Float
+    ): Long
+    private external fun nativeAudioCacheLookup(key: Long): FloatArray?
+    private external fun nativeAudioCachePut(key: Long, pcm: FloatArray)
+    private external fun nativeAudioCacheStats(): LongArray
+
+    private external fun nativeOrtCacheConfigure(dir: String, optLevel: Int): Boolean
+    private external fun nativeOrtCacheModel(model: String): String
+    private external fun nativeOrtCacheDrop(model: String)
+
+    // Native engine (tts_engine.cpp): synthesis and caching without the
+    // OfflineTts JNI library or heap sample arrays
+    private external fun nativeTtsAvailable(): Boolean
+    private external fun nativeTtsLoad(
+        voice: String, model: String, tokens: String, lexicon: String,
+        lengthScale: Float, noiseScale: Float, noiseScaleW: Float, threads: Int, maxVoices: Int
+    ): Boolean
+    private external fun nativeTtsSynthesizeStream(voice: String, text: String, speed: Float, cb: TtsChunkCallback): Int
+    private external fun nativeTtsClipFree(handle: Long)
+    private external fun nativeTtsRelease()
+
+    /**
+     * Synthesized audio, [samples] floats at [sampleRate] Hz mono. From the
+     * native engine it is [direct], a buffer over native memory; from the
+     * OfflineTts fallback it is [floats]. [startsSegment] is false for the
+     * later chunks of a streamed segment. Call [release] once played or dropped.
+     */
+    inner class TtsAudio internal constructor(
+        val samples: Int,
+        val sampleRate: Int,
+        val floats: FloatArray?,
+        val direct: ByteBuffer?,
+        val startsSegment: Boolean = true,
+        private var handle: Long = 0L
+    ) {
+        fun release() {
+            if (handle != 0L) { nativeTtsClipFree(handle); handle = 0L }
+        }
+    }
+
+    /** Synthesis runs in translator_native when it was built with the sherpa-onnx C API. */
+    private val nativeEngine = nativeTtsAvailable()
+
     // LRU cache: mmsCode → loaded OfflineTts instance
     private val modelCache = LinkedHashMap<String, OfflineTts>(
         MAX_CACHED_MODELS + 1, 0.75f, true  // accessOrder=true → LRU
     )
     private val cacheLock = Any()
 
+    init {
+        nativeAudioCacheConfigure(
+            AUDIO_CACHE_MEM_BYTES,
+            audioCacheDir?.apply { mkdirs() }?.absolutePath ?: "",
+            AUDIO_CACHE_DISK_BYTES
+        )
+        val ortCache = nativeOrtCacheConfigure(
+            ortCacheDir?.apply { mkdirs() }?.absolutePath ?: "", ORT_OPT_LEVEL
+        )
+        Log.i(TAG, "Optimized-model cache: ${if (ortCache && ortCacheDir != null) "on" else "off"}")
+    }
+
     // ── Warmup ────────────────────────────────────────────────────────────────
 
     fun warmup(mmsCode: String) {
         Log.i(TAG, "Warming up TTS model: $mmsCode")
-        getOrLoad(mmsCode)
+        if (nativeEngine) loadNative(mmsCode) else getOrLoad(mmsCode)
     }
 
     // ── Primary API ───────────────────────────────────────────────────────────
 
     /**
-     * Synthesises [text] for [mmsCode] (e.g. "eng", "hin").
-     * Returns raw PCM float samples at 22 050 Hz mono.
-     *
-     * [speedOverride] lets the caller nudge speed on top of the language default.
-     * 1.0 = use language default, 0.9 = 10% slower than default, etc.
+     * Audio for [text] in [mmsCode], without a heap copy when the native
+     * engine is available: [onChunk] receives each sentence of the segment,
+     * in order, as soon as VITS has decoded it, so playback can start before
+     * the rest is synthesized. Return false from [onChunk] to stop. A cached
+     * segment arrives as one chunk. Returns the total samples.
      */
-    fun generateSamples(
+    fun synthesizeStreaming(
         text: String,
         mmsCode: String,
-        speedOverride: Float = 0.5f
-    ): FloatArray {
-        if (text.isBlank()) return FloatArray(0)
+        speedOverride: Float = 0.5f,
+        onChunk: (TtsAudio) -> Boolean
+    ): Int {
+        val normalized = normalizeTextForLang(text, mmsCode).trim()
+        if (normalized.isBlank()) return 0
+        var first = true
 
-        val normalized = normalizeTextForLang(text, mmsCode)
-        if (normalized.isBlank()) return FloatArray(0)
+        if (nativeEngine) {
+            if (!loadNative(mmsCode)) {
+                Log.w(TAG, "Model unavailable for $mmsCode — skipping TTS")
+                return 0
+            }
+            val n = nativeTtsSynthesizeStream(mmsCode, normalized, speedOverride,
+                TtsChunkCallback { handle, pcm, sampleRate ->
+                    val buffer = pcm.order(ByteOrder.nativeOrder())
+                    val chunk = TtsAudio(buffer.capacity() / 4, sampleRate, null, buffer, first, handle)
+                    first = false
+                    onChunk(chunk)
+                })
+            return maxOf(n, 0)
+        }
 
+        val key = nativeAudioCacheKey(
+            normalized, mmsCode, LENGTH_SCALE_BY_LANG[mmsCode] ?: 1.20f,
+            NOISE_SCALE, NOISE_SCALE_W, speedOverride
+        )
+        nativeAudioCacheLookup(key)?.let {
+            val rate = synchronized(cacheLock) { modelCache[mmsCode] }?.sampleRate() ?: MMS_SAMPLE_RATE
+            onChunk(TtsAudio(it.size, rate, it, null))
+            return it.size
+        }
         val tts = getOrLoad(mmsCode) ?: run {
             Log.w(TAG, "Model unavailable for $mmsCode — skipping TTS")
-            return FloatArray(0)
+            return 0
         }
-
-        // speed param in sherpa-onnx is the inverse of length_scale —
-        // speed=1.0 means "use model's own length_scale", but we bake
-        // length_scale into the config at load time, so speed=1.0 here
-        // correctly applies our per-language rate.
-        // speedOverride lets callers nudge further if desired.
+        val sampleRate = tts.sampleRate()
+        var stopped = false
         return try {
-            tts.generate(normalized.trim(), sid = 0, speed = speedOverride)?.samples
-                ?: FloatArray(0)
+            val samples = tts.generateWithCallback(normalized, sid = 0, speed = speedOverride) { chunk ->
+                if (chunk.isEmpty()) return@generateWithCallback 1
+                val more = onChunk(TtsAudio(chunk.size, sampleRate, chunk, null, first))
+                first = false
+                if (!more) stopped = true
+                if (more) 1 else 0
+            }.samples
+            if (!stopped && samples.isNotEmpty()) nativeAudioCachePut(key, samples)
+            samples.size
         } catch (e: Exception) {
-            Log.e(TAG, "generate() failed for $mmsCode: ${e.message}")
-            FloatArray(0)
+            Log.e(TAG, "generateWithCallback() failed for $mmsCode: ${e.message}")
+            0
         }
     }
 
     // ── Internal ──────────────────────────────────────────────────────────────
 
+    // The engine keeps its own LRU of MAX_CACHED_MODELS voices
+    private fun loadNative(mmsCode: String): Boolean {
+        val dir     = "$modelDir/$mmsCode"
+        val lexicon = File("$dir/lexicon.txt")
+        return nativeTtsLoad(
+            mmsCode, "$dir/model.onnx", "$dir/tokens.txt",
+            if (lexicon.exists()) lexicon.absolutePath else "",
+            LENGTH_SCALE_BY_LANG[mmsCode] ?: 1.20f, NOISE_SCALE, NOISE_SCALE_W,
+            numThreads, MAX_CACHED_MODELS
+        )
+    }
+
     private fun getOrLoad(mmsCode: String): OfflineTts? {
         synchronized(cacheLock) {
             modelCache[mmsCode]?.let { return it }
@@ -133,28 +252,42 @@ class MmsTtsManager(
         val lengthScale = LENGTH_SCALE_BY_LANG[mmsCode] ?: 1.20f
         Log.i(TAG, "Loading TTS model: $mmsCode  length_scale=$lengthScale")
 
-        return try {
-            val lexiconPath = "$dir/lexicon.txt"
-            val config = OfflineTtsConfig(
-                model = OfflineTtsModelConfig(
-                    vits = OfflineTtsVitsModelConfig(
-                        model       = modelFile.absolutePath,
-                        tokens      = tokensFile.absolutePath,
-                        lexicon     = if (File(lexiconPath).exists()) lexiconPath else "",
-                        lengthScale = lengthScale,
-                        noiseScale  = NOISE_SCALE,
-                        noiseScaleW = NOISE_SCALE_W,
-                    ),
-                    numThreads = 4,
-                    debug      = false
-                )
+        val lexiconPath = "$dir/lexicon.txt"
+        fun create(model: String) = OfflineTts(config = OfflineTtsConfig(
+            model = OfflineTtsModelConfig(
+                vits = OfflineTtsVitsModelConfig(
+                    model       = model,
+                    tokens      = tokensFile.absolutePath,
+                    lexicon     = if (File(lexiconPath).exists()) lexiconPath else "",
+                    lengthScale = lengthScale,
+                    noiseScale  = NOISE_SCALE,
+                    noiseScaleW = NOISE_SCALE_W,
+                ),
+                numThreads = numThreads,
+                debug      = false
             )
-            OfflineTts(config = config).also {
+        ))
+
+        // The graph-optimized copy when there is one; built in the background
+        // from the first load on
+        val model = nativeOrtCacheModel(modelFile.absolutePath)
+        return try {
+            create(model).also {
                 Log.i(TAG, "Loaded TTS model: $mmsCode")
             }
         } catch (e: Exception) {
-            Log.e(TAG, "Failed to load TTS model $mmsCode: ${e.message}")
-            null
+            if (model == modelFile.absolutePath) {
+                Log.e(TAG, "Failed to load TTS model $mmsCode: ${e.message}")
+                return null
+            }
+            Log.w(TAG, "Optimized copy of $mmsCode failed to load (${e.message}); using the original")
+            nativeOrtCacheDrop(modelFile.absolutePath)
+            try {
+                create(modelFile.absolutePath)
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to load TTS model $mmsCode: ${e.message}")
+                null
+            }
         }
     }
 
@@ -197,10 +330,15 @@ class MmsTtsManager(
 
     // ── Lifecycle ─────────────────────────────────────────────────────────────
 
+    /** [hits, disk hits, misses, puts, memory bytes, spill bytes] */
+    fun audioCacheStats(): LongArray = nativeAudioCacheStats()
+
     fun release() {
         synchronized(cacheLock) {
             modelCache.values.forEach { it.release() }
             modelCache.clear()
         }
+        nativeTtsRelease()
+        nativeAudioCacheConfigure(0, "", 0)   // frees memory; spilled files stay
     }
 }
\ No newline at end of file
@@ -7,9 +7,11 @@ import android.media.AudioTrack
 import android.util.Log
 import kotlinx.coroutines.*
 import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.selects.select
 import java.io.File
 import java.util.concurrent.atomic.AtomicBoolean
-import java.util.concurrent.atomic.AtomicReference
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.concurrent.thread
 
 @OptIn(
     kotlinx.coroutines.ExperimentalCoroutinesApi::class,
@@ -21,16 +23,90 @@ class PipelineManager(private val context: Context) {
         private const val TAG                = "PipelineManager"
         private const val WHISPER_THREADS    = 4
         private const val LLAMA_THREADS      = 6
+        private const val TTS_THREADS        = 4
         private const val N_CTX              = 2048
         private const val MIN_SPEECH_SAMPLES = 3200   // ~200ms @ 16kHz
-        private const val TTS_SAMPLE_RATE    = 22050
+        private const val TTS_SAMPLE_RATE    = MmsTtsManager.MMS_SAMPLE_RATE   // until a clip says otherwise
 
-        // ── TTS sentence segmentation ──────────────────────────────────────
-        // Flush to TTS immediately at hard sentence boundaries
-        private val SENTENCE_END = setOf('.', '!', '?', '।', '\n', '،', '、', '，', '\u0964', '\u0965')
-        // Flush at clause boundaries only if the buffer is long enough
-        private val CLAUSE_END   = setOf(',', ';', ':')
-        private const val CLAUSE_FLUSH_MIN = 50   // chars; raised from 40 to avoid tiny clips
+        // ── Stage overlap ──────────────────────────────────────────────────
+        // Whisper (utterance N+1), Llama (utterance N) and TTS can all run at
+        // once. The *_THREADS values above are per-stage maximums; the native
+        // thread budget (thread_budget.cpp) splits the cores between whichever
+        // stages are active. Must match Stage in pipeline_stages.h.
+        private const val STAGE_WHISPER = 0
+        private const val STAGE_LLAMA   = 1
+        private const val STAGE_TTS     = 2
+
+        // ── Model tiers ────────────────────────────────────────────────────
+        // Optional faster models loaded next to the defaults; the native tier
+        // selector (model_tiers.cpp) drops to them per utterance when the
+        // predicted latency would miss these SLOs (hot device, queue backlog).
+        private const val WHISPER_SLO_MS = 1500
+        private const val LLAMA_SLO_MS   = 3000
+
+        // ── Barge-in ───────────────────────────────────────────────────────
+        // New speech during a turn cancels decoding/synthesis and fades out
+        // playback. Speech within MIN_GAP of the turn start is ignored.
+        private const val BARGE_IN_MIN_GAP_MS = 300
+        private const val FADE_OUT_MS         = 10L
+        private const val PRIORITY_NORMAL     = 0
+        private const val PRIORITY_BARGE_IN   = 1
+
+        // ── Utterance scheduler ────────────────────────────────────────────
+        // Bounded queue in front of Whisper (utterance_scheduler.cpp). A job
+        // not started within WAIT_MS (+ WAIT_PER_AUDIO_S_MS per second of its
+        // audio) is shed; fragments under MERGE_MAX_SAMPLES arriving within
+        // MERGE_GAP_MS of the previous one are merged into it.
+        private const val SCHED_CAPACITY            = 4
+        private const val SCHED_WAIT_MS             = 10000
+        private const val SCHED_WAIT_PER_AUDIO_S_MS = 1000
+        private const val SCHED_MERGE_MAX_SAMPLES   = 16000   // 1 s @ 16kHz
+        private const val SCHED_MERGE_GAP_MS        = 1500
+
+        // ── Simultaneous (wait-k) mode ─────────────────────────────────────
+        // While the user speaks, Whisper re-transcribes the growing buffer every
+        // PARTIAL_STEP_SAMPLES; a word commits once two consecutive hypotheses
+        // agree on it. Llama output trails committed source by SIMUL_WAIT_K words.
+        private const val SIMUL_WAIT_K         = 3
+        private const val PARTIAL_STEP_SAMPLES = 16000   // 1 s @ 16kHz
+        // Scripts written without spaces (Thai, Lao, Myanmar, Khmer, kana, CJK
+        // ideographs) count one word per character; see simulWords().
+        private const val UNSPACED =
+            "\\u0E00-\\u0EFF\\u1000-\\u109F\\u1780-\\u17FF\\u3040-\\u30FF\\u3400-\\u4DBF\\u4E00-\\u9FFF\\uF900-\\uFAFF"
+        private val SIMUL_WORD    = Regex("\\s*(?:[$UNSPACED]|[^\\s$UNSPACED]+)")
+        private val LEADING_SPACE = Regex("^\\s+")
+
+        // ── Rolling context ────────────────────────────────────────────────
+        // Earlier turns stay in the KV cache (llama_bridge.cpp) up to this
+        // many tokens; the oldest are evicted first.
+        private const val CONTEXT_MAX_TOKENS = 1024
+
+        // ── Translation memory ─────────────────────────────────────────────
+        // Exact repeats are answered from a memory-mapped file
+        // (translation_memory.cpp) instead of Llama. Fixed size: oldest
+        // entries are overwritten once the record area is full.
+        private const val TM_FILE       = "translation_memory.bin"
+        private const val TM_DATA_BYTES = 8 * 1024 * 1024
+        private const val TM_SLOTS      = 65536
+        // Near repeats (trigram Dice score): used as is above DIRECT when
+        // their numbers match, otherwise given to Llama as a worked example
+        // above HINT
+        private const val TM_FUZZY_DIRECT = 0.9f
+        private const val TM_FUZZY_HINT   = 0.6f
+
+        // ── Glossary ───────────────────────────────────────────────────────
+        // Phrasebook of mandated translations (glossary.cpp), TSV lines of
+        // "src<TAB>tgt<TAB>phrase<TAB>translation", read from filesDir. A
+        // transcript that is exactly one entry skips Llama; entries found
+        // inside a transcript are given to Llama as required terms.
+        private const val PHRASEBOOK_FILE = "phrasebook.tsv"
+
+        // ── LoRA adapters ──────────────────────────────────────────────────
+        // Per-pair adapters on the base model (llama_bridge.cpp), read from
+        // filesDir/ADAPTER_DIR as "<src>-<tgt>.gguf" (language codes, e.g.
+        // en-hi.gguf). An optional "<src>-<tgt>.head.txt" holds the shorter
+        // prompt head the adapter was trained with ({src}/{tgt} placeholders).
+        private const val ADAPTER_DIR = "adapters"
 
         // ── Inter-sentence silence ─────────────────────────────────────────
         // Silence (ms) inserted between synthesised sentences during playback.
@@ -40,10 +116,13 @@ class PipelineManager(private val context: Context) {
 
         // ── Playback drain polling ─────────────────────────────────────────
         // How often (ms) we poll AudioTrack.playbackHeadPosition.
-        // 8ms = ~1 audio frame at 22050Hz; fine-grained enough for accuracy.
+        // 8ms = 128 frames at 16 kHz, 176 at 22.05 kHz; fine-grained enough for accuracy.
         private const val PLAYBACK_POLL_MS = 8L
         // Safety margin added on top of calculated audio duration before timeout.
         private const val PLAYBACK_TIMEOUT_MARGIN_MS = 400L
+        // Frames per AudioTrack write while streaming (16ms at 16 kHz, 12ms at
+        // 22.05 kHz): the barge-in check runs between slices.
+        private const val STREAM_SLICE_FRAMES = 256
 
         private val LANG_TO_MMS = mapOf(
             "en" to "eng", "hi" to "hin", "fr" to "fra",
@@ -58,18 +137,140 @@ class PipelineManager(private val context: Context) {
     // ── JNI ───────────────────────────────────────────────────────────────────
     private external fun nativeWhisperInit(path: String, threads: Int): Boolean
     private external fun nativeWhisperTranscribe(pcm: FloatArray, lang: String): String
+    private external fun nativeWhisperAddTier(path: String): Boolean
     private external fun nativeWhisperFree()
     private external fun nativeLlamaInit(path: String, threads: Int, nCtx: Int): Boolean
-    private external fun nativeLlamaTranslate(prompt: String, cb: TokenCallback)
+    private external fun nativeLlamaAddTier(path: String): Boolean
+    // Prompts are built natively from the model's template (prompt_templates.cpp);
+    // src/tgt are language names
+    private external fun nativeLlamaSimulBegin(src: String, tgt: String, k: Int): Boolean
+    private external fun nativeLlamaSimulPush(words: String, isFinal: Boolean, cb: TokenCallback)
+    private external fun nativeLlamaSimulEnd()
+    private external fun nativeLlamaHistoryConfigure(maxTurns: Int, maxTokens: Int)
+    private external fun nativeLlamaHistoryWarm(src: String, tgt: String): Boolean
+    private external fun nativeLlamaSetSnapshotDir(dir: String)
+    private external fun nativeLlamaBacklogAdd(delta: Int)
+    private external fun nativeLlamaSetScriptMask(enabled: Boolean)
+    private external fun nativeLlamaSetSimulShift(enabled: Boolean)
+    private external fun nativeLlamaSetOutputRules(enabled: Boolean)
+    private external fun nativeLlamaSetEntityMask(enabled: Boolean)
+    private external fun nativeLlamaAddAdapter(src: String, tgt: String, path: String, head: String, scale: Float): Int
+    private external fun nativeLlamaClearAdapters()
+    private external fun nativeLlamaHistoryTranslate(src: String, tgt: String, hint: String, text: String, cb: TokenCallback)
+    private external fun nativeLlamaConvWarm(dir: Int, src: String, tgt: String): Boolean
+    private external fun nativeLlamaConvTranslate(dir: Int, src: String, tgt: String, hint: String, text: String, cb: TokenCallback)
     private external fun nativeLlamaFree()
+    private external fun nativeBudgetSetMax(stage: Int, maxThreads: Int)
+    private external fun nativeStageEnter(stage: Int): Int
+    private external fun nativeStageExit(stage: Int)
+    private external fun nativeThermalStatus(): String
+    private external fun nativeTierConfigure(stage: Int, sloMs: Int)
+    private external fun nativeTierStatus(stage: Int): String
+    private external fun nativeTmOpen(path: String, dataBytes: Int, nSlots: Int): Boolean
+    private external fun nativeTmLookup(src: String, tgt: String, text: String): String?
+    private external fun nativeTmFuzzyLookup(src: String, tgt: String, text: String, minScore: Float): Array<String>?
+    private external fun nativeTmPut(src: String, tgt: String, text: String, translation: String)
+    private external fun nativeTmClose()
+    private external fun nativeTmStats(): LongArray
+    private external fun nativeGlossaryLoad(path: String): Int
+    private external fun nativeGlossaryLookup(src: String, tgt: String, text: String): String?
+    private external fun nativeGlossaryTerms(src: String, tgt: String, text: String): Array<String>
+    private external fun nativeGlossaryClear()
+    private external fun nativeBargeInConfigure(enabled: Boolean, minGapMs: Int)
+    private external fun nativeBargeInSetBusy(busy: Boolean)
+    private external fun nativeBargeInOnSpeech(): Boolean
+    private external fun nativeBargeInEpoch(): Long
+    private external fun nativeSchedConfigure(
+        capacity: Int, maxWaitMs: Int, waitPerAudioSecMs: Int, mergeMaxSamples: Int, mergeGapMs: Int
+    )
+    private external fun nativeSchedSubmit(pcm: FloatArray, priority: Int)
+    private external fun nativeSchedNext(): FloatArray?
+    private external fun nativeSchedReset()
+    private external fun nativeSchedClose()
+    private external fun nativeSchedStats(): LongArray
     private external fun nativeGetBackendInfo(): String
 
     // ── Config & callbacks ────────────────────────────────────────────────────
     var sourceLanguageCode: String = ""
     var targetLanguageCode: String = ""
     var ttsEnabled:         Boolean = true
+    /**
+     * Conversation mode: speaking while a translation is still decoding or
+     * playing preempts it. Needs echo-cancelled input, otherwise the speaker
+     * output itself can trigger the VAD.
+     */
+    var bargeInEnabled:     Boolean = false
+        set(value) {
+            field = value
+            nativeBargeInConfigure(value, BARGE_IN_MIN_GAP_MS)
+        }
+    /** Start translating (and speaking) before the user finishes the utterance. */
+    var simultaneousMode:   Boolean = false
+    /**
+     * Simultaneous mode: splice each new source word in by shifting the
+     * output already decoded instead of decoding it again. Cheaper per word,
+     * but approximate: that output's cached states never see the new words,
+     * so translations may differ from the exact path.
+     */
+    var simulFastSplice:    Boolean = false
+        set(value) {
+            field = value
+            nativeLlamaSetSimulShift(value)
+        }
+    /**
+     * Two-person conversation: swapping source/target flips direction, and
+     * each direction keeps its prompt cached in its own Llama sequence, so the
+     * reply to a turn starts without re-prefilling. Ignored in [simultaneousMode].
+     */
+    var conversationMode:   Boolean = false
+    /**
+     * Number of previous turns kept as context for the next translation
+     * (0 = each utterance translated on its own; the instruction prefix is
+     * still kept cached). Earlier turns stay in the KV cache, so only the new
+     * utterance is prefilled. Ignored in [simultaneousMode] and [conversationMode].
+     */
+    var contextTurns:       Int = 0
+        set(value) {
+            field = value
+            nativeLlamaHistoryConfigure(value, CONTEXT_MAX_TOKENS)
+        }
+
+    /**
+     * Only sample tokens written in the target language's script (plus
+     * digits and punctuation). Turn off if translations should be able to
+     * keep names or terms in the source script.
+     */
+    var targetScriptOnly:   Boolean = true
+        set(value) {
+            field = value
+            nativeLlamaSetScriptMask(value)
+        }
+
+    /**
+     * End the translation at a newline and drop an introduction ("Here is the
+     * translation:") and the quotes around it. Turn off to see the model's
+     * raw output.
+     */
+    var outputRules:        Boolean = true
+        set(value) {
+            field = value
+            nativeLlamaSetOutputRules(value)
+        }
+
+    /**
+     * Give Llama numbers, amounts, phone numbers, times and URLs as short
+     * placeholders and put them back, in the target's number format, in the
+     * translation. Fewer tokens to copy, and digits can't be mistranslated.
+     */
+    var maskEntities:       Boolean = true
+        set(value) {
+            field = value
+            nativeLlamaSetEntityMask(value)
+        }
 
     var onTranscription:    ((String) -> Unit)? = null
+    /** Simultaneous mode: committed source text so far, while still speaking. */
+    var onPartialTranscription: ((String) -> Unit)? = null
     var onTranslationToken: ((String) -> Unit)? = null
     var onTranslationDone:  (() -> Unit)?       = null
     /**
@@ -82,13 +283,39 @@ class PipelineManager(private val context: Context) {
     var onError:            ((String) -> Unit)? = null
 
     // ── Internal state ────────────────────────────────────────────────────────
-    private val busy             = AtomicBoolean(false)
     private val capturingSpeech  = AtomicBoolean(false)
-    private val pendingUtterance = AtomicReference<FloatArray?>(null)
     private val speechBuffer     = mutableListOf<FloatArray>()
+    @Volatile private var bargedIn = false
+
+    // Simultaneous mode. Hypothesis state is only touched on stage-partial.
+    private class SimulChunk(val words: String, val final: Boolean)
+    private var simulChunks:     Channel<SimulChunk>? = null
+    private var simulHypothesis: List<String> = emptyList()
+    private var simulCommitted   = 0
+    private var partialSamples   = 0   // guarded by speechBuffer
+    private val partialInFlight  = AtomicBoolean(false)
+
+    // Utterances waiting for Whisper live in the native scheduler
+    // (utterance_scheduler.cpp): bounded, deadline-shed, short fragments merged.
+    //
+    // Translation turns waiting for the Llama stage, in utterance order.
+    // Whisper may run at most one utterance ahead of translation. A barge-in
+    // drops them; pendingTurns counts them, suspended sends included, and every
+    // change is mirrored natively for Llama's tier selection.
+    private val turnChannel  = Channel<suspend () -> Unit>(capacity = 1)
+    private val pendingTurns = AtomicInteger(0)
+    // Adapter changes and prompt-head warms, served on the Llama stage before
+    // any waiting turn and never dropped by a barge-in
+    private val controlChannel = Channel<suspend () -> Unit>(Channel.UNLIMITED)
 
     // Compute scope: Whisper + Llama inference + TTS synthesis
     private val computeScope = CoroutineScope(Dispatchers.Default + SupervisorJob())
+    // One thread per inference stage; the native side pins each to its core mask
+    private val whisperStage = newSingleThreadContext("stage-whisper")
+    private val llamaStage   = newSingleThreadContext("stage-llama")
+    // Simultaneous-mode partials: stage-whisper is parked in nativeSchedNext().
+    // Whisper calls from both threads are serialized natively by its stage lock.
+    private val partialStage = newSingleThreadContext("stage-partial")
     // Playback scope: single dedicated thread — audio write never preempts compute
     private val playbackScope = CoroutineScope(
         newSingleThreadContext("tts-playback") + SupervisorJob()
@@ -96,10 +323,21 @@ class PipelineManager(private val context: Context) {
 
     private var initialized  = false
     private var ttsManager: MmsTtsManager? = null
+    private val segmenter = TtsSegmenter(INTER_SENTENCE_SILENCE_MS)
 
     // ── Init / release ────────────────────────────────────────────────────────
 
-    fun init(whisperPath: String, llamaPath: String, modelDir: String): Boolean {
+    /**
+     * [whisperTiers] / [llamaTiers] are optional faster fallback models, best
+     * quality first. Missing files are skipped.
+     */
+    fun init(
+        whisperPath: String,
+        llamaPath: String,
+        modelDir: String,
+        whisperTiers: List<String> = emptyList(),
+        llamaTiers: List<String> = emptyList(),
+    ): Boolean {
         if (!File(whisperPath).exists()) { onError?.invoke("Whisper model not found"); return false }
         if (!File(llamaPath).exists())   { onError?.invoke("Llama model not found");   return false }
 
@@ -109,32 +347,143 @@ class PipelineManager(private val context: Context) {
         if (!nativeLlamaInit(llamaPath, LLAMA_THREADS, N_CTX)) {
             onError?.invoke("Failed to load Llama"); return false
         }
+        whisperTiers.filter { File(it).exists() }.forEach { nativeWhisperAddTier(it) }
+        llamaTiers.filter { File(it).exists() }.forEach { nativeLlamaAddTier(it) }
+        nativeTierConfigure(STAGE_WHISPER, WHISPER_SLO_MS)
+        nativeTierConfigure(STAGE_LLAMA, LLAMA_SLO_MS)
+        if (!nativeTmOpen(File(context.filesDir, TM_FILE).absolutePath, TM_DATA_BYTES, TM_SLOTS)) {
+            Log.w(TAG, "Translation memory unavailable")
+        }
+        File(context.filesDir, PHRASEBOOK_FILE).takeIf { it.exists() }?.let { loadPhrasebook(it) }
+        File(context.filesDir, ADAPTER_DIR).listFiles { f -> f.name.endsWith(".gguf") }?.forEach { f ->
+            val pair = f.name.removeSuffix(".gguf").split('-')
+            if (pair.size != 2) return@forEach
+            val head = File(f.parentFile, "${pair[0]}-${pair[1]}.head.txt")
+            loadAdapter(pair[0], pair[1], f, if (head.exists()) head.readText() else "", 1f)
+        }
+        nativeLlamaSetSnapshotDir(File(context.filesDir, "kv_snapshots").apply { mkdirs() }.absolutePath)
 
-        ttsManager = MmsTtsManager(context, modelDir)
+        nativeBudgetSetMax(STAGE_TTS, TTS_THREADS)
+        ttsManager = MmsTtsManager(
+            context, modelDir, TTS_THREADS,
+            File(context.cacheDir, "tts_audio"), File(context.cacheDir, "tts_ort")
+        )
 
         // Pre-warm TTS models for both languages in parallel so first utterance
         // has no cold-start synthesis delay.
         computeScope.launch(Dispatchers.IO) {
             val targetMms = LANG_TO_MMS[targetLanguageCode] ?: "hin"
             val sourceMms = LANG_TO_MMS[sourceLanguageCode] ?: "eng"
-            coroutineScope {
-                launch { ttsManager?.warmup(targetMms) }
-                if (sourceMms != targetMms) launch { ttsManager?.warmup(sourceMms) }
+            // One stage entry for both: entering twice would serialize them on
+            // the stage lock. The second thread is started from the pinned one,
+            // so it inherits the TTS core mask.
+            ttsStage {
+                val other = if (sourceMms != targetMms) {
+                    thread(name = "tts-warmup") { ttsManager?.warmup(sourceMms) }
+                } else null
+                ttsManager?.warmup(targetMms)
+                other?.join()
             }
             Log.i(TAG, "TTS pre-warmed: $targetMms / $sourceMms")
         }
 
+        // Stage workers: each consumes its channel in order, so translations
+        // come out in the same order the utterances were spoken.
+        nativeSchedConfigure(
+            SCHED_CAPACITY, SCHED_WAIT_MS, SCHED_WAIT_PER_AUDIO_S_MS,
+            SCHED_MERGE_MAX_SAMPLES, SCHED_MERGE_GAP_MS
+        )
+        nativeSchedReset()
+        computeScope.launch(whisperStage) {
+            while (isActive) {
+                val pcm = nativeSchedNext() ?: break   // null once closed
+                transcribeStage(pcm)
+            }
+        }
+        computeScope.launch(llamaStage) {
+            while (true) {
+                // select is biased to its first clause: control commands first
+                val job = select<(suspend () -> Unit)?> {
+                    controlChannel.onReceiveCatching { it.getOrNull() }
+                    turnChannel.onReceiveCatching { r ->
+                        r.getOrNull()?.also { countTurns(-1) }
+                    }
+                } ?: break
+                job()
+            }
+        }
+
         Log.i(TAG, "Backend: ${nativeGetBackendInfo()}")
         initialized = true
+        prewarmPrompt()
         return true
     }
 
+    /**
+     * Loads the Llama prompt head for the current language pair (and mode)
+     * ahead of the next utterance: restored from its KV snapshot if one
+     * exists, prefilled and saved otherwise. Call after changing languages.
+     */
+    fun prewarmPrompt() {
+        if (!initialized || simultaneousMode) return
+        // If a turn is already queued it will load the head itself
+        if (pendingTurns.get() > 0) return
+        controlChannel.trySend {
+            if (conversationMode) {
+                val dir = if (sourceLanguageCode <= targetLanguageCode) 0 else 1
+                nativeLlamaConvWarm(dir, sourceName(), targetName())
+                nativeLlamaConvWarm(1 - dir, targetName(), sourceName())
+            } else {
+                nativeLlamaHistoryWarm(sourceName(), targetName())
+            }
+        }
+    }
+
+    /**
+     * Uses the LoRA adapter [file] for [srcCode] → [tgtCode] from the next
+     * request on. [head] (optional) replaces the prompt head for the pair;
+     * see [ADAPTER_DIR]. Loaded on the Llama stage, before any queued turn.
+     */
+    fun addLanguageAdapter(srcCode: String, tgtCode: String, file: File, head: String = "", scale: Float = 1f) {
+        controlChannel.trySend { loadAdapter(srcCode, tgtCode, file, head, scale) }
+    }
+
+    /** Drops all adapters; every pair goes back to the base model. */
+    fun clearLanguageAdapters() {
+        controlChannel.trySend { nativeLlamaClearAdapters() }
+    }
+
+    private fun loadAdapter(srcCode: String, tgtCode: String, file: File, head: String, scale: Float) {
+        val n = nativeLlamaAddAdapter(getLanguageName(srcCode), getLanguageName(tgtCode),
+                                      file.absolutePath, head, scale)
+        if (n > 0) Log.i(TAG, "Adapter $srcCode→$tgtCode: ${file.name} on $n tier(s)")
+        else       Log.w(TAG, "Adapter $srcCode→$tgtCode not loaded: ${file.name}")
+    }
+
+    /**
+     * Replaces the phrasebook with [file] (format in [PHRASEBOOK_FILE]'s
+     * comment). Returns the number of entries, or -1 if it cannot be read.
+     */
+    fun loadPhrasebook(file: File): Int {
+        val n = nativeGlossaryLoad(file.absolutePath)
+        Log.i(TAG, "Phrasebook ${file.name}: $n entries")
+        return n
+    }
+
     fun release() {
+        nativeSchedClose()
+        turnChannel.close()
+        controlChannel.close()
         computeScope.cancel()
         playbackScope.cancel()
+        whisperStage.close()
+        llamaStage.close()
+        partialStage.close()
         if (initialized) {
             nativeWhisperFree()
             nativeLlamaFree()
+            nativeTmClose()
+            nativeGlossaryClear()
             ttsManager?.release()
             initialized = false
         }
@@ -144,14 +493,51 @@ class PipelineManager(private val context: Context) {
 
     fun onSpeechStart() {
         if (!initialized) return
-        synchronized(speechBuffer) { speechBuffer.clear() }
+        synchronized(speechBuffer) {
+            speechBuffer.clear()
+            partialSamples = 0
+        }
         capturingSpeech.set(true)
+
+        bargedIn = nativeBargeInOnSpeech()
+        if (bargedIn) {
+            // The speaker has moved on: transcripts not yet translated are
+            // stale. Adapter and warm commands are on controlChannel and stay.
+            while (turnChannel.tryReceive().isSuccess) {
+                countTurns(-1)
+                Log.i(TAG, "Barge-in: dropped pending transcript")
+            }
+        }
+
+        if (simultaneousMode) {
+            val chunks = Channel<SimulChunk>(Channel.UNLIMITED)
+            computeScope.launch(partialStage) {
+                simulChunks     = chunks
+                simulHypothesis = emptyList()
+                simulCommitted  = 0
+            }
+            // Undispatched: the send is queued from this thread, so turns
+            // reach the Llama stage in the order speech started.
+            computeScope.launch(start = CoroutineStart.UNDISPATCHED) {
+                queueTurn { simulTurn(chunks) }
+            }
+        }
         Log.d(TAG, "Speech capture started")
     }
 
     fun submitChunk(pcm: FloatArray) {
         if (!initialized || !capturingSpeech.get()) return
-        synchronized(speechBuffer) { speechBuffer.add(pcm.copyOf()) }
+        val snapshot = synchronized(speechBuffer) {
+            speechBuffer.add(pcm.copyOf())
+            if (!simultaneousMode) return
+            partialSamples += pcm.size
+            if (partialSamples < PARTIAL_STEP_SAMPLES || !partialInFlight.compareAndSet(false, true)) return
+            partialSamples = 0
+            speechBuffer.flatMap { it.toList() }.toFloatArray()
+        }
+        computeScope.launch(partialStage) {
+            try { partialTranscribe(snapshot, final = false) } finally { partialInFlight.set(false) }
+        }
     }
 
     fun onSpeechEnd() {
@@ -166,46 +552,60 @@ class PipelineManager(private val context: Context) {
 
         Log.d(TAG, "Speech end: ${merged.size} samples (${merged.size / 16}ms)")
 
+        if (simultaneousMode) {
+            // Always finalize, even if short: the Llama turn is already waiting
+            computeScope.launch(partialStage) { partialTranscribe(merged, final = true) }
+            return
+        }
+
         if (merged.size < MIN_SPEECH_SAMPLES) {
             Log.d(TAG, "Too short, ignoring utterance")
             return
         }
 
-        if (busy.compareAndSet(false, true)) {
-            computeScope.launch { runPipeline(merged) }
-        } else {
-            // Queue latest utterance; drop older queued one if any
-            val dropped = pendingUtterance.getAndSet(merged)
-            if (dropped != null) Log.w(TAG, "Dropped queued utterance (pipeline busy)")
-        }
+        nativeSchedSubmit(merged, if (bargedIn) PRIORITY_BARGE_IN else PRIORITY_NORMAL)
     }
 
+    /**
+     * Scheduler counters: submitted, started, merged, shed (deadline),
+     * shed (overflow), queue depth, max queue wait in ms.
+     */
+    fun schedulerStats(): LongArray = nativeSchedStats()
+
+    /** Translation memory counters: hits, misses, puts, bytes used. */
+    fun translationMemoryStats(): LongArray = nativeTmStats()
+
     // ── Core pipeline ─────────────────────────────────────────────────────────
     //
     //  Architecture (pipelined):
     //
+    //  native scheduler ──► transcribeStage (stage-whisper)
+    //                           │
+    //       turnChannel ──► translateStage | simulTurn (stage-llama)
+    //    controlChannel ──► adapters, head warms (served first)
+    //
+    //  Whisper transcribes utterance N+1 while Llama translates utterance N.
+    //
     //  Llama token stream
-    //      │ sentence boundary
+    //      │ segment boundary (TtsSegmenter)
     //      ▼
-    //  synthChannel (UNLIMITED) ──► synthesisJob (Default):
-    //                                   generateSamples() ──► audioChannel (capacity=2)
-    //                                                              │
+    //  synthChannel (UNLIMITED) ──► synthesisJob (IO):
+    //                                   synthesizeStreaming() ──► audioChannel (UNLIMITED)
+    //                                       one chunk per sentence          │
     //                                                   playbackJob (tts-playback):
-    //                                                       playAudioStatic()  [blocking]
-    //                                                       inter-sentence silence
+    //                                                       StreamPlayer (MODE_STREAM)
+    //                                                       inter-segment silence
     //
-    //  Sentence N+1 is synthesised while sentence N is playing.
-    //  Gap between sentences = INTER_SENTENCE_SILENCE_MS only.
+    //  Playback starts with the first decoded sentence of the first segment;
+    //  the rest is synthesised while it plays, into the same AudioTrack.
+    //  Gap between segments = INTER_SENTENCE_SILENCE_MS only.
     //
     //  onTtsDone fires after playbackJob completes — AFTER last audio drains.
     //  This is the correct signal for "safe to start next recording".
 
-    private suspend fun runPipeline(pcm: FloatArray) {
+    private suspend fun transcribeStage(pcm: FloatArray) {
         try {
-            // ── 1. Transcribe ──────────────────────────────────────────────
-            val transcribed = withContext(Dispatchers.Default) {
-                nativeWhisperTranscribe(pcm, sourceLanguageCode)
-            }.trim()
+            val transcribed = nativeWhisperTranscribe(pcm, sourceLanguageCode).trim()
 
             if (transcribed.isBlank()) {
                 Log.w(TAG, "Whisper returned empty result")
@@ -213,30 +613,139 @@ class PipelineManager(private val context: Context) {
                 return
             }
             Log.i(TAG, "Whisper → \"$transcribed\"")
-            onTranscription?.invoke(transcribed)
+            val st = nativeSchedStats()
+            if (st[3] + st[4] > 0) {
+                Log.w(TAG, "Scheduler: depth=${st[5]} shed=${st[3]}+${st[4]} merged=${st[2]}")
+            }
+            queueTurn { translateStage(transcribed) }
 
-            // ── 2. Text-only path (TTS disabled) ──────────────────────────
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(TAG, "Transcription error: ${e.message}", e)
+            onError?.invoke(e.message ?: "Unknown transcription error")
+        }
+    }
+
+    private suspend fun translateStage(transcribed: String) {
+        onTranscription?.invoke(transcribed)
+        val src = sourceLanguageCode
+        val tgt = targetLanguageCode
+
+        // Phrasebook entry: the mandated translation, no Llama
+        nativeGlossaryLookup(src, tgt, transcribed)?.let { fixed ->
+            Log.i(TAG, "Phrasebook hit → \"$fixed\"")
+            runTurn { cb -> cb.onToken(fixed) }
+            return
+        }
+        // Exact repeat: skip Llama, the stored text goes straight to TTS
+        nativeTmLookup(src, tgt, transcribed)?.let { cached ->
+            Log.i(TAG, "Translation memory hit → \"$cached\"")
+            runTurn { cb -> cb.onToken(cached) }
+            return
+        }
+        // Near repeat: [source, translation, score, same numbers]
+        val similar = nativeTmFuzzyLookup(src, tgt, transcribed, TM_FUZZY_HINT)
+        if (similar != null && similar[2].toFloat() >= TM_FUZZY_DIRECT && similar[3] == "1") {
+            Log.i(TAG, "Translation memory fuzzy hit (${similar[2]}) → \"${similar[1]}\"")
+            runTurn { cb -> cb.onToken(similar[1]) }
+            return
+        }
+
+        // Phrasebook entries inside the transcript: [phrase, translation, ...]
+        val terms = nativeGlossaryTerms(src, tgt, transcribed).toList().chunked(2)
+        val required = if (terms.isEmpty()) "" else
+            "Use these translations: " +
+                terms.joinToString("; ") { (p, t) -> "\"$p\" → \"$t\"" } + "\n"
+
+        val epoch = nativeBargeInEpoch()
+        val output = StringBuilder()
+        runTurn { cb ->
+            val recording = TokenCallback { token -> output.append(token); cb.onToken(token) }
+            if (conversationMode) conversationTurn(transcribed, recording, required)
+            else historyTurn(transcribed, recording, similar, required)
+        }
+        // A preempted turn is incomplete and must not be remembered
+        if (nativeBargeInEpoch() == epoch && output.isNotBlank()) {
+            nativeTmPut(src, tgt, transcribed, output.toString().trim())
+        }
+    }
+
+    private fun historyTurn(
+        transcribed: String,
+        cb: TokenCallback,
+        similar: Array<String>?,
+        required: String,
+    ) {
+        // Also with contextTurns == 0: the instruction prefix stays cached
+        // A close earlier translation, as a worked example for terminology
+        val example = similar?.let { "Similar: \"${it[0]}\" → \"${it[1]}\"\n" } ?: ""
+        nativeLlamaHistoryTranslate(sourceName(), targetName(), example + required, transcribed, cb)
+    }
+
+    private fun conversationTurn(transcribed: String, cb: TokenCallback, required: String) {
+        // Directions are keyed by language order, so a swap flips them
+        val dir = if (sourceLanguageCode <= targetLanguageCode) 0 else 1
+        nativeLlamaConvTranslate(dir, sourceName(), targetName(), required, transcribed, cb)
+        // Reply head as a command of its own, so the tail segment doesn't
+        // wait for it; skipped if an utterance is already queued, or natively
+        // if the reply's adapter differs from this one's. No-op once cached.
+        if (pendingTurns.get() > 0) return
+        val src = targetName()
+        val tgt = sourceName()
+        controlChannel.trySend { nativeLlamaConvWarm(1 - dir, src, tgt) }
+    }
+
+    /** Queues a translation turn for the Llama stage, in call order. */
+    private suspend fun queueTurn(turn: suspend () -> Unit) {
+        countTurns(1)
+        try {
+            turnChannel.send(turn)
+        } catch (e: Throwable) {   // cancelled, or the channel closed
+            countTurns(-1)
+            throw e
+        }
+    }
+
+    private fun countTurns(delta: Int) {
+        pendingTurns.addAndGet(delta)
+        nativeLlamaBacklogAdd(delta)
+    }
+
+    /**
+     * Runs one translation turn: [generate] drives Llama and feeds tokens to
+     * the callback it is given; tokens stream to the UI and, segment by
+     * segment, into synthesis and playback. Returns after playback drains.
+     */
+    private suspend fun runTurn(generate: suspend (TokenCallback) -> Unit) {
+        val epoch = nativeBargeInEpoch()
+        fun preempted() = nativeBargeInEpoch() != epoch
+
+        nativeBargeInSetBusy(true)
+        try {
+            // ── 1. Text-only path (TTS disabled) ──────────────────────────
             if (!ttsEnabled) {
                 val sb = StringBuilder()
-                withContext(Dispatchers.Default) {
-                    nativeLlamaTranslate(buildPrompt(transcribed)) { token ->
-                        sb.append(token)
-                        onTranslationToken?.invoke(token)
-                    }
-                }
+                generate(TokenCallback { token ->
+                    sb.append(token)
+                    onTranslationToken?.invoke(token)
+                })
                 Log.i(TAG, "Llama → \"${sb.trim()}\"")
                 onTranslationDone?.invoke()
                 onTtsDone?.invoke()
                 return
             }
 
-            // ── 3. Pipelined translate + synthesise + play ─────────────────
+            // ── 2. Pipelined translate + synthesise + play ─────────────────
             val mmsCode = LANG_TO_MMS[targetLanguageCode.lowercase()] ?: "eng"
+            segmenter.startTurn(mmsCode)
 
             // Channel: sentence strings → synthesis worker
             val synthChannel = Channel<String>(Channel.UNLIMITED)
-            // Channel: audio float arrays → playback worker (1 ahead buffer)
-            val audioChannel = Channel<FloatArray>(capacity = 2)
+            // Channel: synthesized chunks → playback worker. Unbounded: chunks are
+            // sent from inside the TTS stage, which must not wait on playback.
+            // A chunk that is never received frees its native clip.
+            val audioChannel = Channel<MmsTtsManager.TtsAudio>(Channel.UNLIMITED) { it.release() }
 
             // Worker A — synthesis on IO dispatcher (unbounded pool).
             // CRITICAL: must NOT use Dispatchers.Default here — Llama.translate()
@@ -244,73 +753,95 @@ class PipelineManager(private val context: Context) {
             // IO has an unbounded thread pool so synthesis runs concurrently with Llama.
             val synthesisJob = computeScope.launch(Dispatchers.IO) {
                 for (sentence in synthChannel) {
+                    if (preempted()) continue   // drain without synthesising
                     val t0 = System.currentTimeMillis()
-                    val samples = ttsManager?.generateSamples(sentence, mmsCode)
-                        ?: FloatArray(0)
+                    var firstMs = -1L
+                    var rate = TTS_SAMPLE_RATE
+                    val n = ttsStage {
+                        ttsManager?.synthesizeStreaming(sentence, mmsCode) { chunk ->
+                            if (firstMs < 0) firstMs = System.currentTimeMillis() - t0
+                            rate = chunk.sampleRate
+                            if (preempted()) {
+                                chunk.release()
+                                false
+                            } else {
+                                audioChannel.trySend(chunk).isSuccess.also { sent ->
+                                    if (!sent) chunk.release()   // playback has stopped
+                                }
+                            }
+                        }
+                    } ?: 0
                     val genMs = System.currentTimeMillis() - t0
-                    val durMs = if (samples.isNotEmpty())
-                        samples.size.toLong() * 1000L / TTS_SAMPLE_RATE else 0L
-                    Log.i(TAG, "TTS synthesis: ${samples.size} samples, " +
-                            "duration=${durMs}ms, genTime=${genMs}ms, text=\"$sentence\"")
-                    if (samples.isNotEmpty()) audioChannel.send(samples)
+                    val durMs = n.toLong() * 1000L / rate
+                    Log.i(TAG, "TTS synthesis: $n samples, duration=${durMs}ms, " +
+                            "firstChunk=${firstMs}ms, genTime=${genMs}ms, text=\"$sentence\"")
+                    segmenter.onSynthesized(sentence.length, durMs, genMs)
                 }
                 audioChannel.close()
             }
 
             // Worker B — playback (dedicated thread; never shares CPU with synthesis)
             val playbackJob = playbackScope.launch {
-                var firstChunk = true
-                for (samples in audioChannel) {
-                    // Insert silence between sentences (not before the very first one)
-                    if (!firstChunk) {
-                        Thread.sleep(INTER_SENTENCE_SILENCE_MS)
+                val player = StreamPlayer(epoch)
+                try {
+                    for (audio in audioChannel) {
+                        if (preempted()) { audio.release(); continue }
+                        // Insert silence between segments (not before the very first one)
+                        if (audio.startsSegment && player.framesWritten > 0) {
+                            player.writeSilence(INTER_SENTENCE_SILENCE_MS)
+                        }
+                        segmenter.onPlaybackStart()
+                        player.write(audio)
+                        audio.release()
                     }
-                    firstChunk = false
-                    playAudioStatic(samples)
+                } finally {
+                    // Cancelled: clips still queued go back to native memory
+                    // (onUndeliveredElement), as do any sent after this
+                    audioChannel.cancel()
                 }
+                player.drainAndClose()
                 // *** THIS is the correct place to fire onTtsDone ***
                 // Audio has fully drained; it is now safe to open the microphone.
                 Log.i(TAG, "All TTS playback complete")
                 onTtsDone?.invoke()
             }
 
-            // ── 4. Translate, flushing segments to synthChannel ────────────
+            // ── 3. Translate, flushing segments to synthChannel ────────────
             val fullTranslation = StringBuilder()
             val segmentBuffer   = StringBuilder()
 
-            // Run Llama on IO — it's a blocking JNI call. Using Dispatchers.IO ensures
-            // it doesn't occupy all Default threads, which would starve the synthesisJob
-            // (also on IO) and prevent TTS from starting until translation is complete.
-            withContext(Dispatchers.IO) {
-                nativeLlamaTranslate(buildPrompt(transcribed)) { token ->
-                    fullTranslation.append(token)
-                    segmentBuffer.append(token)
-                    onTranslationToken?.invoke(token)
-
-                    val lastChar = token.lastOrNull() ?: return@nativeLlamaTranslate
-
-                    val isSentenceEnd = lastChar in SENTENCE_END && segmentBuffer.length > 4
-                    val isClauseEnd   = lastChar in CLAUSE_END
-                            && segmentBuffer.length >= CLAUSE_FLUSH_MIN
+            // Llama blocks the stage-llama thread, never a Default or IO pool
+            // thread, so the synthesisJob starts as soon as the first segment lands.
+            generate(TokenCallback { token ->
+                fullTranslation.append(token)
+                segmentBuffer.append(token)
+                onTranslationToken?.invoke(token)
 
-                    if (isSentenceEnd || isClauseEnd) {
-                        val segment = prepareForTts(segmentBuffer.toString())
-                        segmentBuffer.clear()
-                        if (segment.isNotBlank()) {
-                            Log.d(TAG, "Flushing TTS segment: \"$segment\"")
-                            synthChannel.trySend(segment)
-                        }
+                val cut = segmenter.cut(segmentBuffer, token)
+                if (cut > 0) {
+                    val segment = prepareForTts(segmentBuffer.substring(0, cut))
+                    segmentBuffer.delete(0, cut)
+                    if (segment.isNotBlank()) {
+                        Log.d(TAG, "Flushing TTS segment: \"$segment\"")
+                        segmenter.onFlushed(segment.length)
+                        synthChannel.trySend(segment)
                     }
                 }
-            }
+            })
 
             Log.i(TAG, "Llama → \"${fullTranslation.trim()}\"")
+            Log.i(TAG, "Thermal: ${nativeThermalStatus()}")
+            Log.i(TAG, "Tiers: ${nativeTierStatus(STAGE_WHISPER)} / ${nativeTierStatus(STAGE_LLAMA)}")
+            ttsManager?.audioCacheStats()?.let {
+                Log.i(TAG, "TTS cache: hits=${it[0]} (+${it[1]} from disk), misses=${it[2]}")
+            }
             onTranslationDone?.invoke()
 
-            // Flush tail (text after the last sentence boundary)
+            // Flush tail (text after the last segment boundary)
             val tail = prepareForTts(segmentBuffer.toString())
-            if (tail.isNotBlank()) {
+            if (tail.isNotBlank() && !preempted()) {
                 Log.d(TAG, "Flushing TTS tail: \"$tail\"")
+                segmenter.onFlushed(tail.length)
                 synthChannel.trySend(tail)
             }
             synthChannel.close()
@@ -326,67 +857,207 @@ class PipelineManager(private val context: Context) {
             Log.e(TAG, "Pipeline error: ${e.message}", e)
             onError?.invoke(e.message ?: "Unknown pipeline error")
         } finally {
-            busy.set(false)
-            // If a new utterance arrived while we were busy, run it now
-            val queued = pendingUtterance.getAndSet(null)
-            if (queued != null && busy.compareAndSet(false, true)) {
-                computeScope.launch { runPipeline(queued) }
+            nativeBargeInSetBusy(false)
+        }
+    }
+
+    // ── Simultaneous mode ─────────────────────────────────────────────────────
+    //
+    //  capture ──(every 1 s)──► partialTranscribe (stage-partial): local agreement
+    //                               │ newly committed words
+    //                               ▼
+    //                           simulChunks ──► simulTurn (stage-llama):
+    //                                               nativeLlamaSimulPush(...)
+
+    private fun partialTranscribe(pcm: FloatArray, final: Boolean) {
+        val chunks = simulChunks ?: return
+        val words = if (pcm.size >= MIN_SPEECH_SAMPLES)
+            simulWords(nativeWhisperTranscribe(pcm, sourceLanguageCode).trim())
+        else emptyList()
+
+        // Local agreement: the prefix both hypotheses share is stable
+        val stable = if (final) words.size
+            else words.zip(simulHypothesis).takeWhile { (a, b) -> a == b }.size
+        simulHypothesis = words
+
+        if (stable > simulCommitted || final) {
+            val fresh = if (simulCommitted < stable) words.subList(simulCommitted, stable) else emptyList()
+            simulCommitted = maxOf(stable, simulCommitted)
+            Log.d(TAG, "Simul commit (${if (final) "final" else "partial"}): \"${fresh.joinToString("")}\"")
+            chunks.trySend(SimulChunk(fresh.joinToString(""), final))
+            onPartialTranscription?.invoke(words.take(simulCommitted).joinToString(""))
+        }
+        if (final) {
+            Log.i(TAG, "Whisper (simul) → \"${words.joinToString("")}\"")
+            chunks.close()
+            simulChunks = null
+        }
+    }
+
+    // Words for local agreement, each with the whitespace before it so they
+    // join back into the text. Scripts written without spaces (CJK, Thai,
+    // ...) count one word per character; llama_bridge.cpp counts the same way.
+    private fun simulWords(text: String): List<String> =
+        SIMUL_WORD.findAll(text).map { it.value.replace(LEADING_SPACE, " ") }.toList()
+
+    private suspend fun simulTurn(chunks: Channel<SimulChunk>) {
+        if (!nativeLlamaSimulBegin(sourceName(), targetName(), SIMUL_WAIT_K)) {
+            onError?.invoke("Simultaneous translation failed to start")
+            for (chunk in chunks) { /* drain */ }
+            return
+        }
+        onTranscription?.invoke("")
+        try {
+            runTurn { cb ->
+                for (chunk in chunks) {
+                    nativeLlamaSimulPush(chunk.words, chunk.final, cb)
+                    if (chunk.final) break
+                }
             }
+        } finally {
+            nativeLlamaSimulEnd()
         }
     }
 
     // ── TTS playback ──────────────────────────────────────────────────────────
 
     /**
-     * Writes [samples] to an AudioTrack (MODE_STATIC) and blocks until the
-     * hardware audio buffer has fully drained.
+     * One MODE_STREAM AudioTrack per turn. Chunks are written as synthesis
+     * delivers them, so playback starts with the first sentence of a segment
+     * and later ones queue behind it. Native audio is written from its direct
+     * buffer, without a copy on the JVM heap.
      *
-     * Uses playbackHeadPosition polling instead of Thread.sleep(audioDuration)
-     * so there is no fixed over/under-wait padding.
+     * Writes go in slices of [STREAM_SLICE_FRAMES], so a barge-in that moves
+     * the epoch past [epoch] is seen within one slice; the track is then
+     * faded out within [FADE_OUT_MS] and everything after is dropped.
      */
-    private fun playAudioStatic(samples: FloatArray) {
-        val track = AudioTrack.Builder()
-            .setAudioAttributes(
-                AudioAttributes.Builder()
-                    .setUsage(AudioAttributes.USAGE_MEDIA)
-                    .setContentType(AudioAttributes.CONTENT_TYPE_SPEECH)
-                    .build()
-            )
-            .setAudioFormat(
-                AudioFormat.Builder()
-                    .setEncoding(AudioFormat.ENCODING_PCM_FLOAT)
-                    .setSampleRate(TTS_SAMPLE_RATE)
-                    .setChannelMask(AudioFormat.CHANNEL_OUT_MONO)
-                    .build()
+    private inner class StreamPlayer(private val epoch: Long) {
+        private var track: AudioTrack? = null
+        private var stopped = false
+        private var rate = TTS_SAMPLE_RATE   // the first clip's, once one is written
+        private val t0 = System.currentTimeMillis()
+        private val silence = FloatArray(STREAM_SLICE_FRAMES)
+
+        /** Frames written so far, silence included. */
+        var framesWritten = 0L
+            private set
+
+        private fun open(): AudioTrack {
+            val minBytes = AudioTrack.getMinBufferSize(
+                rate, AudioFormat.CHANNEL_OUT_MONO, AudioFormat.ENCODING_PCM_FLOAT
             )
-            .setTransferMode(AudioTrack.MODE_STATIC)
-            .setBufferSizeInBytes(samples.size * 4)  // 4 bytes per float
-            .build()
-
-        val t0 = System.currentTimeMillis()
-        track.write(samples, 0, samples.size, AudioTrack.WRITE_BLOCKING)
-        track.play()
-
-        // Drain: poll head position until all frames are consumed.
-        val audioDurationMs = samples.size.toLong() * 1000L / TTS_SAMPLE_RATE
-        val deadline = System.currentTimeMillis() + audioDurationMs + PLAYBACK_TIMEOUT_MARGIN_MS
-
-        while (track.playbackHeadPosition < samples.size) {
-            if (System.currentTimeMillis() > deadline) {
-                Log.w(TAG, "Playback drain timeout after ${audioDurationMs}ms")
-                break
+            return AudioTrack.Builder()
+                .setAudioAttributes(
+                    AudioAttributes.Builder()
+                        .setUsage(AudioAttributes.USAGE_MEDIA)
+                        .setContentType(AudioAttributes.CONTENT_TYPE_SPEECH)
+                        .build()
+                )
+                .setAudioFormat(
+                    AudioFormat.Builder()
+                        .setEncoding(AudioFormat.ENCODING_PCM_FLOAT)
+                        .setSampleRate(rate)
+                        .setChannelMask(AudioFormat.CHANNEL_OUT_MONO)
+                        .build()
+                )
+                .setTransferMode(AudioTrack.MODE_STREAM)
+                .setBufferSizeInBytes(maxOf(minBytes, STREAM_SLICE_FRAMES * 4 * 4))
+                .build()
+        }
+
+        private fun fadeOut(t: AudioTrack) {
+            t.setVolume(0f)   // AudioFlinger ramps this, no click
+            Thread.sleep(FADE_OUT_MS)
+            t.pause()
+            t.flush()
+            stopped = true
+            Log.i(TAG, "Playback faded out (barge-in)")
+        }
+
+        /** Writes the first [total] frames of [audio], or silence if null; false once stopped. */
+        private fun writeSlices(audio: MmsTtsManager.TtsAudio?, total: Int): Boolean {
+            if (stopped) return false
+            if (audio != null && audio.sampleRate != rate) {
+                rate = audio.sampleRate
+                track?.setPlaybackRate(rate)   // a voice with another rate mid-turn
             }
-            Thread.sleep(PLAYBACK_POLL_MS)
+            val t = track ?: open().also { track = it }
+            val direct = audio?.direct
+            var off = 0
+            while (off < total) {
+                if (nativeBargeInEpoch() != epoch) { fadeOut(t); return false }
+                val n = minOf(STREAM_SLICE_FRAMES, total - off)
+                val written = when {
+                    audio == null  -> t.write(silence, 0, n, AudioTrack.WRITE_BLOCKING)
+                    direct != null -> {
+                        direct.limit((off + n) * 4)
+                        direct.position(off * 4)
+                        t.write(direct, n * 4, AudioTrack.WRITE_BLOCKING) / 4
+                    }
+                    else           -> t.write(audio.floats!!, off, n, AudioTrack.WRITE_BLOCKING)
+                }
+                if (written <= 0) {
+                    Log.w(TAG, "AudioTrack write failed ($written)")
+                    return false
+                }
+                off += written
+                framesWritten += written
+                if (t.playState != AudioTrack.PLAYSTATE_PLAYING) t.play()
+            }
+            return true
+        }
+
+        fun write(audio: MmsTtsManager.TtsAudio) {
+            writeSlices(audio, audio.samples)
         }
 
-        track.stop()
-        track.release()
-        Log.i(TAG, "TTS playback done (${System.currentTimeMillis() - t0}ms, " +
-                "expected ${audioDurationMs}ms)")
+        fun writeSilence(ms: Long) {
+            writeSlices(null, (ms * rate / 1000L).toInt())
+        }
+
+        /**
+         * Blocks until everything written has played, polling
+         * playbackHeadPosition rather than sleeping for the computed duration.
+         */
+        fun drainAndClose() {
+            val t = track ?: return
+            track = null
+            if (!stopped) {
+                val remainingMs = (framesWritten - t.playbackHeadPosition) * 1000L / rate
+                val deadline = System.currentTimeMillis() + remainingMs + PLAYBACK_TIMEOUT_MARGIN_MS
+                while (t.playbackHeadPosition < framesWritten) {
+                    if (nativeBargeInEpoch() != epoch) { fadeOut(t); break }
+                    if (System.currentTimeMillis() > deadline) {
+                        Log.w(TAG, "Playback drain timeout after ${remainingMs}ms")
+                        break
+                    }
+                    Thread.sleep(PLAYBACK_POLL_MS)
+                }
+            }
+            t.stop()
+            t.release()
+            Log.i(TAG, "TTS playback done (${System.currentTimeMillis() - t0}ms, " +
+                    "${framesWritten * 1000L / rate}ms of audio)")
+        }
     }
 
     // ── Helpers ───────────────────────────────────────────────────────────────
 
+    /**
+     * Runs a TTS call inside the native thread budget: Llama and Whisper
+     * shrink while it runs, and the calling thread is pinned to the TTS cores.
+     * Model loads go through here too, so ONNX Runtime's pool threads inherit
+     * the TTS core mask when they are created.
+     */
+    private inline fun <T> ttsStage(block: () -> T): T {
+        nativeStageEnter(STAGE_TTS)
+        try {
+            return block()
+        } finally {
+            nativeStageExit(STAGE_TTS)
+        }
+    }
+
     /**
      * Cleans a translation segment for TTS input.
      *
@@ -412,16 +1083,6 @@ class PipelineManager(private val context: Context) {
         else -> "English"
     }
 
-    private fun buildPrompt(text: String): String {
-        val src = getLanguageName(sourceLanguageCode)
-        val tgt = getLanguageName(targetLanguageCode)
-        return buildString {
-            append("<start_of_turn>user\n")
-            append("Translate the following $src text to $tgt. ")
-            append("Output only the translated $tgt text, nothing else.\n\n")
-            append("Text: \"$text\"\n")
-            append("<end_of_turn>\n")
-            append("<start_of_turn>model\n")
-        }
-    }
-}
\ No newline at end of file
+    private fun sourceName() = getLanguageName(sourceLanguageCode)
+    private fun targetName() = getLanguageName(targetLanguageCode)
+}
@@ -0,0 +1,9 @@
+package com.example.speechtranslator
+
+fun interface TtsChunkCallback {
+    /**
+     * [pcm] is a direct buffer over native clip [handle], at [sampleRate] Hz.
+     * Return false to stop.
+     */
+    fun onChunk(handle: Long, pcm: java.nio.ByteBuffer, sampleRate: Int): Boolean
+}
@@ -0,0 +1,125 @@
+package com.example.speechtranslator
+
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Decides where the streamed translation is cut into TTS segments.
+ *
+ * The first segment of a turn ends at the first word-group boundary past
+ * [FIRST_MIN_CHARS], so a long opening sentence doesn't hold back the first
+ * audio. Later segments may grow: a boundary is taken only once the segment
+ * is as long as the audio already queued ahead of the playhead can cover at
+ * the measured synthesis speed. With a deep queue, sentences are merged into
+ * fewer, larger synthesis calls; as it runs low, boundaries are taken as
+ * they come so the playback queue doesn't run dry.
+ *
+ * Speed estimates are kept per voice across turns; queue state is per turn.
+ * [cut] and [onFlushed] run on the Llama thread, [onSynthesized] on the
+ * synthesis worker and [onPlaybackStart] on the playback thread.
+ */
+class TtsSegmenter(private val gapMs: Long) {
+    companion object {
+        // Flush at hard sentence boundaries
+        private val SENTENCE_END = setOf('.', '!', '?', '।', '\n', '،', '、', '，', '\u0964', '\u0965')
+        // Flush at clause boundaries only if the segment is long enough
+        private val CLAUSE_END   = setOf(',', ';', ':')
+
+        // First segment: a clause boundary counts past FIRST_MIN_CHARS, and a
+        // plain word boundary past FIRST_MAX_CHARS.
+        private const val FIRST_MIN_CHARS = 12
+        private const val FIRST_MAX_CHARS = 48
+
+        // Later segments: a sentence boundary counts from LATER_MIN_CHARS, a
+        // clause boundary from CLAUSE_FLUSH_MIN (tiny clips cost a whole
+        // synthesis call each), and a word boundary past LATER_MAX_CHARS.
+        private const val LATER_MIN_CHARS  = 24
+        private const val CLAUSE_FLUSH_MIN = 50
+        private const val LATER_MAX_CHARS  = 220
+
+        // Share of the computed budget a segment may use, for estimate error
+        private const val QUEUE_SAFETY = 0.6f
+        // Weight of a new measurement in the running estimates
+        private const val EMA_ALPHA = 0.3f
+        // Synthesis faster than this share of the audio is a cache hit, not a measurement
+        private const val CACHED_RTF = 0.02f
+    }
+
+    private class Speed(
+        @Volatile var rtf: Float = 0.35f,        // synthesis ms per audio ms
+        @Volatile var msPerChar: Float = 70f     // audio ms per character
+    )
+
+    private val speeds = HashMap<String, Speed>()
+    @Volatile private var speed = Speed()
+
+    private var first = true
+    private var queuedMs = 0f                    // audio flushed this turn, estimated
+    private val pendingChars = AtomicInteger(0)  // flushed, not yet synthesized
+    @Volatile private var playStartMs = 0L
+
+    fun startTurn(voice: String) {
+        speed = synchronized(speeds) { speeds.getOrPut(voice) { Speed() } }
+        first = true
+        queuedMs = 0f
+        pendingChars.set(0)
+        playStartMs = 0L
+    }
+
+    /**
+     * How many leading chars of [buffer] to flush now that [token] has been
+     * appended to it; 0 to keep accumulating.
+     */
+    fun cut(buffer: CharSequence, token: String): Int {
+        val last = token.lastOrNull() ?: return 0
+        val len  = buffer.length
+        if (first) {
+            if (last in SENTENCE_END && len > 4) return len
+            if (last in CLAUSE_END && len >= FIRST_MIN_CHARS) return len
+            return wordCut(buffer, token, FIRST_MAX_CHARS)
+        }
+        val target = laterTarget()
+        if (last in SENTENCE_END && len >= target) return len
+        if (last in CLAUSE_END && len >= maxOf(target, CLAUSE_FLUSH_MIN)) return len
+        return wordCut(buffer, token, LATER_MAX_CHARS)
+    }
+
+    // Cuts before a token that starts a new word, once the text before it is long
+    private fun wordCut(buffer: CharSequence, token: String, max: Int): Int {
+        val before = buffer.length - token.length
+        return if (token.first() == ' ' && before >= max) before else 0
+    }
+
+    // Length the next segment should reach: synthesis of everything not yet
+    // synthesized, this segment included, has to finish before the audio
+    // already queued has played.
+    private fun laterTarget(): Int {
+        val s = speed
+        if (s.rtf >= 1f) return LATER_MAX_CHARS   // can't keep up: fewest calls
+        val played = if (playStartMs == 0L) 0L else System.currentTimeMillis() - playStartMs
+        val leadMs = (queuedMs - played).coerceAtLeast(0f)
+        val chars  = leadMs * QUEUE_SAFETY / s.rtf / s.msPerChar - pendingChars.get()
+        return chars.toInt().coerceIn(LATER_MIN_CHARS, LATER_MAX_CHARS)
+    }
+
+    /** A segment of [chars] characters went to synthesis. */
+    fun onFlushed(chars: Int) {
+        queuedMs += chars * speed.msPerChar + if (first) 0L else gapMs
+        pendingChars.addAndGet(chars)
+        first = false
+    }
+
+    /** A segment of [chars] characters gave [audioMs] of audio in [genMs]. */
+    fun onSynthesized(chars: Int, audioMs: Long, genMs: Long) {
+        pendingChars.addAndGet(-chars)
+        if (audioMs <= 0 || chars <= 0) return
+        val s = speed
+        s.msPerChar += EMA_ALPHA * (audioMs.toFloat() / chars - s.msPerChar)
+        val rtf = genMs.toFloat() / audioMs
+        if (rtf >= CACHED_RTF) s.rtf += EMA_ALPHA * (rtf - s.rtf)
+    }
+
+    /** The first audio of the turn reached the AudioTrack. */
+    fun onPlaybackStart() {
+        if (playStartMs == 0L) playStartMs = System.currentTimeMillis()
+    }
+}
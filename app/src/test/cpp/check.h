@@ -0,0 +1,29 @@
+#pragma once
+// Minimal assertions for the host tests: a failed CHECK reports and marks the
+// run failed, the test carries on; main returns check_result().
+#include <cstdio>
+
+inline int& check_failures() { static int n = 0; return n; }
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++check_failures();                                                 \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        const auto& _a = (a);                                                   \
+        const auto& _b = (b);                                                   \
+        if (!(_a == _b)) {                                                      \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed\n", __FILE__, __LINE__, #a, #b); \
+            ++check_failures();                                                 \
+        }                                                                       \
+    } while (0)
+
+inline int check_result() {
+    if (check_failures()) fprintf(stderr, "%d check(s) failed\n", check_failures());
+    return check_failures() ? 1 : 0;
+}
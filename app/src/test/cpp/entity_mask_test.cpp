@@ -0,0 +1,130 @@
+// entity_mask: detection (phone numbers vs spaced numbers, non-ASCII
+// digits), restoring across piece boundaries, dropped entities, and number
+// reuse across history turns.
+#include "check.h"
+#include "entity_mask.h"
+#include <string>
+#include <vector>
+
+// Restores pieces as they would stream from the model.
+static std::string restore(EntityMap& map, const std::vector<std::string>& pieces,
+                           bool append_missing = true) {
+    std::string all, out;
+    for (const std::string& p : pieces) {
+        entity_restore(map, p, out);
+        all += out;
+    }
+    entity_restore_end(map, append_missing, out);
+    return all + out;
+}
+
+static void test_spaced_numbers_are_not_phones() {
+    EntityMap map;
+    CHECK_EQ(entity_mask("between 1990 2000", "English", "English", map),
+             std::string("between \xC2\xA7" "1 \xC2\xA7" "2"));
+    CHECK_EQ(map.values.size(), (size_t)2);
+    CHECK_EQ(map.values[0], std::string("1990"));   // a year stays ungrouped
+    CHECK_EQ(map.values[1], std::string("2000"));
+
+    map = EntityMap();
+    CHECK_EQ(entity_mask("call 98765 43210 now", "English", "English", map),
+             std::string("call \xC2\xA7" "1 now"));
+    CHECK_EQ(map.values[0], std::string("98765 43210"));
+    map = EntityMap();
+    CHECK_EQ(entity_mask("dial +91 98765 43210", "English", "English", map),
+             std::string("dial \xC2\xA7" "1"));
+    map = EntityMap();
+    CHECK_EQ(entity_mask("scores 10 20 30 40", "English", "English", map),
+             std::string("scores 10 20 30 40"));   // short plain integers stay
+}
+
+static void test_devanagari_digits() {
+    EntityMap map;
+    // "my number is ९८७६५ ४३२१०": a phone number, restored as spoken
+    const std::string phone = "\xE0\xA5\xAF\xE0\xA5\xAE\xE0\xA5\xAD\xE0\xA5\xAC\xE0\xA5\xAB "
+                              "\xE0\xA5\xAA\xE0\xA5\xA9\xE0\xA5\xA8\xE0\xA5\xA7\xE0\xA5\xA6";
+    CHECK_EQ(entity_mask("number " + phone, "Hindi", "English", map),
+             std::string("number \xC2\xA7" "1"));
+    CHECK_EQ(map.values[0], phone);
+
+    // "१२,३४,५६७" in Indian grouping, rendered for English
+    const std::string lakh = "\xE0\xA5\xA7\xE0\xA5\xA8,\xE0\xA5\xA9\xE0\xA5\xAA,"
+                             "\xE0\xA5\xAB\xE0\xA5\xAC\xE0\xA5\xAD";
+    map = EntityMap();
+    CHECK_EQ(entity_mask("\xE2\x82\xB9" + lakh, "Hindi", "English", map),
+             std::string("\xC2\xA7" "1"));
+    CHECK_EQ(map.values[0], std::string("\xE2\x82\xB9" "1,234,567"));
+
+    // and an English amount rendered with Arabic-Indic digits
+    map = EntityMap();
+    CHECK_EQ(entity_mask("12.5%", "English", "Arabic", map), std::string("\xC2\xA7" "1"));
+    CHECK_EQ(map.values[0], std::string("\xD9\xA1\xD9\xA2\xD9\xAB\xD9\xA5%"));   // ١٢٫٥%
+}
+
+static void test_placeholder_split_across_pieces() {
+    EntityMap map;
+    entity_mask("Pay $1,250.50 now", "English", "German", map);
+    CHECK_EQ(restore(map, { "Zahlen Sie ", "\xC2\xA7", "1", " jetzt" }),
+             std::string("Zahlen Sie $1.250,50 jetzt"));
+
+    // Two-digit numbers split after the first digit (pieces reach the
+    // restorer as whole characters, so § itself is never split)
+    std::string text;
+    for (int i = 0; i < 12; ++i) text += std::to_string(100 + i) + " ";
+    map = EntityMap();
+    entity_mask(text, "English", "English", map);
+    CHECK_EQ(map.values.size(), (size_t)12);
+    CHECK_EQ(restore(map, { "x \xC2\xA7" "1", "2 y \xC2\xA7", "3" }), std::string("x 111 y 102") +
+             " 100 101 103 104 105 106 107 108 109 110");   // the rest were dropped
+
+    // Not one of ours: passed through
+    map = EntityMap();
+    entity_mask("Room 404", "English", "English", map);
+    CHECK_EQ(restore(map, { "\xC2\xA7" "9 \xC2\xA7", "1" }), std::string("\xC2\xA7" "9 404"));
+}
+
+static void test_dropped_entity_is_appended() {
+    EntityMap map;
+    CHECK_EQ(entity_mask("Room 404 at 10:30", "English", "French", map),
+             std::string("Room \xC2\xA7" "1 at \xC2\xA7" "2"));
+    CHECK_EQ(restore(map, { "Chambre ", "\xC2\xA7" "1" }), std::string("Chambre 404 10:30"));
+    map = EntityMap();
+    entity_mask("Room 404 at 10:30", "English", "French", map);
+    CHECK_EQ(restore(map, { "Chambre ", "\xC2\xA7" "1" }, false), std::string("Chambre 404"));
+}
+
+// Rolling history: numbers held by resident turns are never handed out
+// again, numbers of an evicted turn are, so the map stays small.
+static void test_numbers_reused_after_release() {
+    EntityMap map;
+    entity_mask("from 1990 to 2000", "English", "English", map);
+    const std::vector<int> turn1 = map.current;
+    CHECK_EQ(turn1, (std::vector<int>{ 1, 2 }));
+    std::string out;
+
+    CHECK_EQ(entity_mask("call 555-1234", "English", "English", map),
+             std::string("call \xC2\xA7" "3"));
+    const std::vector<int> turn2 = map.current;
+    // A placeholder copied forward from turn 1 still restores its value,
+    // but only this turn's dropped entities are appended
+    CHECK_EQ(restore(map, { "\xC2\xA7" "1" }), std::string("1990 555-1234"));
+
+    entity_release(map, turn1);
+    CHECK_EQ(entity_mask("at 10:30", "English", "English", map), std::string("at \xC2\xA7" "1"));
+    CHECK_EQ(map.values[0], std::string("10:30"));
+    CHECK_EQ(restore(map, { "\xC2\xA7" "3 \xC2\xA7" "1" }), std::string("555-1234 10:30"));
+    CHECK_EQ(restore(map, { "\xC2\xA7" "2" }), std::string("\xC2\xA7" "2"));   // freed
+
+    entity_release(map, turn2);
+    entity_release(map, map.current);
+    CHECK(map.values.empty());
+}
+
+int main() {
+    test_spaced_numbers_are_not_phones();
+    test_devanagari_digits();
+    test_placeholder_split_across_pieces();
+    test_dropped_entity_is_appended();
+    test_numbers_reused_after_release();
+    return check_result();
+}
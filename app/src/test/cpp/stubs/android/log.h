@@ -0,0 +1,16 @@
+#pragma once
+// Host stand-in for the NDK log header: messages go to stderr.
+#include <cstdarg>
+#include <cstdio>
+
+enum { ANDROID_LOG_DEBUG = 3, ANDROID_LOG_INFO = 4, ANDROID_LOG_WARN = 5, ANDROID_LOG_ERROR = 6 };
+
+inline int __android_log_print(int, const char* tag, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "%s: ", tag);
+    const int n = vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+    return n;
+}
@@ -0,0 +1,108 @@
+// Drives thermal_monitor through heat and cool-down with injected
+// temperatures, clock and throughput reports.
+#include "check.h"
+#include "thermal_monitor.h"
+
+static int     g_temp_mc = 50000;
+static int64_t g_now_ms  = 1000000;
+
+static int     read_temp()  { return g_temp_mc; }
+static int64_t clock_ms()   { return g_now_ms; }
+
+// One sample period later.
+static int tick() {
+    g_now_ms += 1000;
+    thermal_tick();
+    return thermal_level();
+}
+
+// Ticks through one cool-down period.
+static int cool_down() {
+    int lvl = thermal_level();
+    for (int i = 0; i < 10; ++i) lvl = tick();
+    return lvl;
+}
+
+// n reports of tok_s on n_threads.
+static void llama_at(int n_threads, double tok_s, int n) {
+    for (int i = 0; i < n; ++i) thermal_report(STAGE_LLAMA, n_threads, tok_s, 1000.0);
+}
+
+static void test_temperature_heat_then_cool() {
+    g_temp_mc = 50000;
+    CHECK_EQ(tick(), 0);
+    CHECK_EQ(thermal_prefill_chunk(), 512);
+
+    g_temp_mc = 90000;
+    CHECK_EQ(tick(), 3);                 // straight up
+    CHECK_EQ(thermal_prefill_chunk(), 64);
+
+    g_temp_mc = 50000;
+    CHECK_EQ(tick(), 3);                 // cool-down starts
+    CHECK_EQ(cool_down(), 2);            // one level per period
+    CHECK_EQ(cool_down(), 1);
+    CHECK_EQ(cool_down(), 0);
+
+    g_temp_mc = 80000;
+    CHECK_EQ(tick(), 2);
+    g_temp_mc = 50000;
+    tick();
+    CHECK_EQ(cool_down(), 1);
+    CHECK_EQ(cool_down(), 0);
+}
+
+// Collapse on 8 threads throttles to 4; once cool, the first healthy rates
+// back on 8 threads must not be judged by the EMA left from the collapse.
+static void test_collapse_then_recover_without_sawtooth() {
+    g_temp_mc = 50000;
+    llama_at(8, 20.0, 5);                // best on 8 threads: 20 tok/s
+    CHECK_EQ(tick(), 0);
+
+    llama_at(8, 8.0, 6);                 // governor clamps: EMA falls below 55%
+    CHECK_EQ(tick(), 2);
+
+    llama_at(4, 12.0, 5);                // throttled run, steady
+    tick();
+    CHECK_EQ(cool_down(), 1);
+    llama_at(4, 12.0, 5);
+    CHECK_EQ(cool_down(), 0);
+
+    llama_at(8, 20.0, 1);                // full budget again, rate recovered
+    CHECK_EQ(tick(), 0);
+    llama_at(8, 20.0, 4);
+    CHECK_EQ(tick(), 0);
+    ThermalStatus st = thermal_status();
+    CHECK(st.llama_tok_s > 19.0f);
+    CHECK(st.llama_best_tok_s > 19.0f);
+
+    llama_at(8, 8.0, 6);                 // a real collapse is still caught
+    CHECK_EQ(tick(), 2);
+    g_temp_mc = 50000;
+    tick();
+    cool_down();
+    CHECK_EQ(cool_down(), 0);
+}
+
+// Fewer than FRESH_SAMPLES reports after a change don't move the level.
+static void test_few_reports_are_ignored() {
+    llama_at(8, 20.0, 3);
+    CHECK_EQ(tick(), 0);
+    g_temp_mc = 70000;
+    CHECK_EQ(tick(), 1);                 // rates reset
+    llama_at(8, 5.0, 2);                 // 25% of best, but only two reports
+    CHECK_EQ(tick(), 1);
+    llama_at(8, 5.0, 1);
+    CHECK_EQ(tick(), 2);
+    g_temp_mc = 50000;
+}
+
+int main() {
+    thermal_set_reader(read_temp);
+    thermal_set_clock(clock_ms);
+    test_temperature_heat_then_cool();
+    test_collapse_then_recover_without_sawtooth();
+    test_few_reports_are_ignored();
+    thermal_set_clock(nullptr);
+    thermal_set_reader(nullptr);
+    return check_result();
+}
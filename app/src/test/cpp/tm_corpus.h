@@ -0,0 +1,60 @@
+#pragma once
+// Synthetic phrasebook for the translation memory test and benchmark:
+// sentences of 5..12 words drawn from a fixed vocabulary, seeded so runs
+// repeat, and near-repeats with one word swapped.
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TmCorpus {
+public:
+    explicit TmCorpus(uint32_t seed) : state_(seed ? seed : 1) {}
+
+    std::string sentence() {
+        const int n = 5 + (int)(next() % 8);
+        std::string s;
+        for (int i = 0; i < n; ++i) {
+            if (i) s += ' ';
+            s += word();
+        }
+        return s;
+    }
+
+    // s with one word replaced.
+    std::string near_repeat(const std::string& s) {
+        std::vector<std::string> words;
+        size_t start = 0;
+        for (size_t i = 0; i <= s.size(); ++i) {
+            if (i == s.size() || s[i] == ' ') { words.push_back(s.substr(start, i - start)); start = i + 1; }
+        }
+        words[next() % words.size()] = word();
+        std::string out;
+        for (size_t i = 0; i < words.size(); ++i) {
+            if (i) out += ' ';
+            out += words[i];
+        }
+        return out;
+    }
+
+    uint32_t next() {   // xorshift32
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+
+private:
+    std::string word() {
+        static const char* const SYL[] = {
+            "ka", "to", "ri", "men", "sa", "lo", "vi", "dan", "pe", "mu",
+            "shi", "ar", "ne", "bo", "tal", "qu", "ze", "fin", "ho", "gu",
+            "ra", "wel", "cy", "op", "ni", "stra", "ju", "ek", "pol", "ma",
+        };
+        const int n = 1 + (int)(next() % 3);
+        std::string w;
+        for (int i = 0; i < n; ++i) w += SYL[next() % (sizeof(SYL) / sizeof(SYL[0]))];
+        return w;
+    }
+
+    uint32_t state_;
+};
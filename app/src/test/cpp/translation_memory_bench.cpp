@@ -0,0 +1,40 @@
+// Fuzzy lookup latency at 100k entries. Not a ctest test; run by hand:
+//   _gate_build/translation_memory_bench [entries] [queries]
+#include "tm_corpus.h"
+#include "translation_memory.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const int n_entries = argc > 1 ? atoi(argv[1]) : 100000;
+    const int n_queries = argc > 2 ? atoi(argv[2]) : 2000;
+    const char* path = "translation_memory_bench.tm";
+    remove(path);
+    if (!tm_open(path, 64u * 1024 * 1024, 1u << 18)) return 1;
+
+    TmCorpus corpus(1);
+    std::vector<std::string> src;
+    for (int i = 0; i < n_entries; ++i) {
+        src.push_back(corpus.sentence());
+        tm_put("English", "Hindi", src.back(), std::to_string(i));
+    }
+    std::vector<std::string> queries;
+    for (int i = 0; i < n_queries; ++i) queries.push_back(corpus.near_repeat(src[corpus.next() % src.size()]));
+
+    using Clock = std::chrono::steady_clock;
+    int hits = 0;
+    const auto t0 = Clock::now();
+    for (const std::string& q : queries) {
+        TmFuzzyHit hit;
+        hits += tm_fuzzy_lookup("English", "Hindi", q, 0.7f, hit);
+    }
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    printf("%d entries, %d queries: %.3f ms per fuzzy lookup, %d hits\n",
+           n_entries, n_queries, ms / n_queries, hits);
+    tm_close();
+    remove(path);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Exact and fuzzy lookup of translation_memory: persistence, wrap-around
+// invalidation, the number-equality gate, and prefix-filter recall against a
+// brute-force Dice scan of the same entries.
+#include "check.h"
+#include "tm_corpus.h"
+#include "translation_memory.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static const char* const PATH = "translation_memory_test.tm";
+
+static void test_exact_and_reopen() {
+    remove(PATH);
+    CHECK(tm_open(PATH, 64 * 1024, 1024));
+    tm_put("English", "Hindi", "Where is the bathroom?", "शौचालय कहाँ है?");
+    std::string out;
+    CHECK(tm_lookup("English", "Hindi", "where is the bathroom ?", out));
+    CHECK_EQ(out, std::string("शौचालय कहाँ है?"));
+    CHECK(!tm_lookup("English", "French", "Where is the bathroom?", out));
+    CHECK(!tm_lookup("English", "Hindi", "Where is the bathroom", out));   // '?' is kept
+
+    tm_close();
+    CHECK(tm_open(PATH, 64 * 1024, 1024));
+    out.clear();
+    CHECK(tm_lookup("English", "Hindi", "Where is the bathroom?", out));
+    CHECK_EQ(out, std::string("शौचालय कहाँ है?"));
+    TmFuzzyHit hit;
+    CHECK(tm_fuzzy_lookup("English", "Hindi", "Where's the bathroom?", 0.6f, hit));   // index rebuilt on open
+    tm_close();
+}
+
+static void test_number_gate() {
+    remove(PATH);
+    CHECK(tm_open(PATH, 64 * 1024, 1024));
+    tm_put("English", "French", "Book 2 tickets for the 5 pm show", "Réservez 2 billets pour la séance de 17 h");
+    TmFuzzyHit hit;
+    CHECK(tm_fuzzy_lookup("English", "French", "Book 3 tickets for the 5 pm show", 0.6f, hit));
+    CHECK(!hit.same_numbers);
+    CHECK(tm_fuzzy_lookup("English", "French", "book 2 tickets for the 5 pm show please", 0.6f, hit));
+    CHECK(hit.same_numbers);
+    CHECK(tm_fuzzy_lookup("English", "French", "Book २ tickets for the ५ pm show!", 0.5f, hit));
+    CHECK(hit.same_numbers);                                  // Devanagari digits read as ASCII
+    CHECK(tm_fuzzy_lookup("English", "French", "Book 2 tickets for the 15 pm show", 0.6f, hit));
+    CHECK(!hit.same_numbers);                                 // 5 vs 15: whole runs compared
+    CHECK(!tm_fuzzy_lookup("English", "Hindi", "Book 2 tickets for the 5 pm show", 0.6f, hit));
+    tm_close();
+}
+
+// A 4 KB record area wraps many times over; overwritten records must read as
+// misses both exactly and through the fuzzy index, and the rebuilds the
+// wrap triggers must keep the live ones findable.
+static void test_wrap_around() {
+    remove(PATH);
+    CHECK(tm_open(PATH, 4096, 256));
+    TmCorpus corpus(7);
+    std::vector<std::string> src;
+    for (int i = 0; i < 400; ++i) {
+        src.push_back(corpus.sentence());
+        tm_put("English", "German", src.back(), "t" + std::to_string(i));
+    }
+    CHECK(tm_stats().bytes_used == 4096);
+
+    int live = 0;
+    for (int i = 0; i < 400; ++i) {
+        std::string out;
+        const bool found = tm_lookup("English", "German", src[i], out);
+        if (found) {
+            ++live;
+            // Only the last write of a sentence is live, and it is a recent one
+            CHECK(std::stoi(out.substr(1)) >= 300);
+        }
+        TmFuzzyHit hit;
+        if (tm_fuzzy_lookup("English", "German", src[i], 0.99f, hit)) {
+            CHECK(found);
+            CHECK_EQ(hit.translation, out);
+        }
+    }
+    CHECK(live > 0);
+    CHECK(live < 100);   // a 4 KB area holds a few dozen records
+    tm_close();
+}
+
+// Brute-force Dice over normalized sources, as tm_fuzzy_lookup defines it.
+static std::vector<uint32_t> grams_of(const std::string& text) {
+    const std::string s = " " + tm_normalize(text) + " ";
+    std::vector<uint32_t> g;
+    for (size_t i = 0; i + 3 <= s.size(); ++i) {
+        g.push_back((uint32_t)(unsigned char)s[i] | (uint32_t)(unsigned char)s[i + 1] << 8 |
+                    (uint32_t)(unsigned char)s[i + 2] << 16);
+    }
+    std::sort(g.begin(), g.end());
+    g.erase(std::unique(g.begin(), g.end()), g.end());
+    return g;
+}
+
+static float dice(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    size_t i = 0, j = 0;
+    int    n = 0;
+    while (i < a.size() && j < b.size()) {
+        if      (a[i] < b[j]) ++i;
+        else if (b[j] < a[i]) ++j;
+        else { ++n; ++i; ++j; }
+    }
+    return 2.0f * n / (float)(a.size() + b.size());
+}
+
+static void test_prefix_filter_recall() {
+    remove(PATH);
+    CHECK(tm_open(PATH, 8 * 1024 * 1024, 1 << 15));
+    TmCorpus corpus(42);
+    std::vector<std::string>           src;
+    std::vector<std::vector<uint32_t>> grams;
+    for (int i = 0; i < 10000; ++i) {
+        src.push_back(corpus.sentence());
+        grams.push_back(grams_of(src.back()));
+        tm_put("English", "Spanish", src.back(), std::to_string(i));
+    }
+
+    const float t = 0.7f;
+    int expected = 0, found = 0;
+    for (int q = 0; q < 500; ++q) {
+        const std::string query = corpus.near_repeat(src[corpus.next() % src.size()]);
+        const std::vector<uint32_t> qg = grams_of(query);
+        float best = 0.0f;
+        for (const auto& g : grams) best = std::max(best, dice(qg, g));
+        if (best < t) continue;
+        ++expected;
+        TmFuzzyHit hit;
+        if (tm_fuzzy_lookup("English", "Spanish", query, t, hit) && hit.score >= best - 1e-4f) ++found;
+    }
+    fprintf(stderr, "prefix-filter recall: %d / %d\n", found, expected);
+    CHECK(expected > 100);
+    CHECK(found == expected);
+    tm_close();
+}
+
+int main() {
+    test_exact_and_reopen();
+    test_number_gate();
+    test_wrap_around();
+    test_prefix_filter_recall();
+    remove(PATH);
+    return check_result();
+}